@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+# Merge-buffer benchmark over a reference run, in place of the bufferWrite.py / process_run.sh /
+# sort_runs.sh / getEntries.C loop. For every combination of GEBMerge bigbufsize and wosize and
+# GEBSort timewin the run is merged, built into the raw tree and sorted through GeneralSort and
+# PTMonitors (bench_sort.C). With --builder, the in-memory event builder of GeneralSortGEB.C is
+# also run over the digitizer files for each timewin. Each row of the table records:
+#   wall time of each stage and in total, peak RSS of the merge/build, events built, EVZ and EXE
+#   entries, throughput (events/s) and the loss of events and EXE counts relative to the best row
+# The table is written to --out (and printed), and bench_plot.C plots throughput against loss.
+#   python3 bench_merge.py --run 25 --bigbufsize 450,5400,10350,20250,45000 --wosize 50,100 --timewin 1000
+# =============================================================================================== #
+import argparse
+import glob
+import itertools
+import os
+import re
+import subprocess
+import time
+
+here = os.path.dirname(os.path.abspath(__file__))
+
+parser = argparse.ArgumentParser(description="Sweep GEBMerge/GEBSort parameters over a reference run")
+parser.add_argument("--run", type=int, default=25)
+parser.add_argument("--exp", default="iss000")
+parser.add_argument("--dir", default="/home/ptmac/Documents/07-CERN-ISS-Mg/analysis",
+	help="analysis directory holding GEBSort/, data/ and working/")
+parser.add_argument("--sortdir", default=os.path.join(here, "..", "sort-codes"),
+	help="directory of GeneralSort.C and PTMonitors.C")
+parser.add_argument("--bigbufsize", default="450,5400,10350,15300,20250,25200,30150,35100,40050,45000")
+parser.add_argument("--wosize", default="50,100", help="in percent of bigbufsize")
+parser.add_argument("--timewin", default="1000", help="coincidence window in 10 ns ticks")
+parser.add_argument("--builder", action="store_true", help="also run the in-memory event builder")
+parser.add_argument("--option", default="", help="extra GeneralSort/PTMonitors options, e.g. max=")
+parser.add_argument("--work", default=os.path.join(here, "bench_work"), help="directory for temporary files")
+parser.add_argument("--keep", action="store_true", help="keep the merged and sorted files")
+parser.add_argument("--out", default=os.path.join(here, "bench_merge.tsv"))
+args = parser.parse_args()
+
+columns = ["path", "bigbufsize", "wosize", "timewin", "merge_s", "build_s", "sort_s", "total_s",
+	"peak_rss_MB", "events", "EVZ", "EXE", "kevents_per_s", "event_loss", "EXE_loss"]
+
+
+def ints(text):
+	return [int(x) for x in text.split(",") if x != ""]
+
+
+def run(cmd, log):
+	# Run one stage. Returns its wall time, its peak RSS in MB and its output.
+	t0 = time.time()
+	with open(log, "w") as f:
+		p = subprocess.Popen(cmd, stdout=f, stderr=subprocess.STDOUT)
+		_, status, usage = os.wait4(p.pid, 0)
+		p.returncode = os.waitstatus_to_exitcode(status)
+	wall = time.time() - t0
+	if p.returncode != 0:
+		print("  %s failed (exit %d), see %s" % (os.path.basename(cmd[0]), p.returncode, log))
+	return wall, usage.ru_maxrss/1024.0, open(log).read()
+
+
+def write_chat(template, out, values):
+	# Copy a chat file with the given "key value" lines replaced
+	text = open(template).read()
+	for key, value in values.items():
+		text = re.sub(r"(?m)^%s\s+\S+" % key, "%s %s" % (key, value), text)
+	open(out, "w").write(text)
+
+
+def sort(inputs, tag, mode, timewin):
+	# GeneralSort + PTMonitors via bench_sort.C. Returns the stage time, RSS and (events, EVZ, EXE).
+	macro = 'bench_sort.C("%s","%s",%d,%d,"%s")' % (inputs, args.sortdir, mode, timewin, option)
+	wall, rss, out = run(["root", "-l", "-b", "-q", os.path.join(here, macro)],
+		os.path.join(args.work, "sort-%s.log" % tag))
+	m = re.search(r"^BENCH\s+(\d+)\s+(\d+)\s+(\d+)", out, re.M)
+	if not m:
+		raise SystemExit("No counts from the %s sort, see %s" % (tag, os.path.join(args.work, "sort-%s.log" % tag)))
+	return wall, rss, [int(x) for x in m.groups()]
+
+
+option = "map=%s %s" % (os.path.join(here, "map.dat"), args.option)
+os.makedirs(args.work, exist_ok=True)
+os.chdir(args.work)
+
+# Compile the sort codes once, so that it is not timed in the first row
+compile = ["root", "-l", "-b", "-q"]
+for c in ("GeneralSort.C", "GeneralSortGEB.C", "PTMonitors.C"):
+	compile += ["-e", ".L %s+" % os.path.join(args.sortdir, c)]
+subprocess.call(compile)
+
+data = sorted(glob.glob(os.path.join(args.dir, "data", "%s_run_%d.gtd*" % (args.exp, args.run))))
+if not data:
+	raise SystemExit("No data files %s/data/%s_run_%d.gtd*" % (args.dir, args.exp, args.run))
+gebdir = os.path.join(args.dir, "GEBSort")
+
+rows = []
+for bb, wo, tw in itertools.product(ints(args.bigbufsize), ints(args.wosize), ints(args.timewin)):
+	tag = "%d-%d-%d" % (bb, wo, tw)
+	print("bigbufsize %d, wosize %d, timewin %d" % (bb, wo, tw))
+	mergeChat = os.path.join(args.work, "GEBMerge-%s.chat" % tag)
+	sortChat = os.path.join(args.work, "GEBSort-%s.chat" % tag)
+	write_chat(os.path.join(args.dir, "working", "GEBMerge.chat"), mergeChat, {"bigbufsize": bb, "wosize": wo})
+	write_chat(os.path.join(here, "GEBSort.chat"), sortChat, {"timewin": tw})
+
+	merged = os.path.join(args.work, "GEBMerged-%s.gtd" % tag)
+	raw = os.path.join(args.work, "run-%s.root" % tag)
+	tMerge, rssMerge, _ = run([os.path.join(gebdir, "GEBMerge"), mergeChat, merged] + data,
+		os.path.join(args.work, "merge-%s.log" % tag))
+	tBuild, rssBuild, _ = run([os.path.join(gebdir, "GEBSort_nogeb"), "-input", "disk", merged + "_000",
+		"-rootfile", raw, "RECREATE", "-chat", sortChat], os.path.join(args.work, "build-%s.log" % tag))
+	tSort, _, counts = sort(raw, tag, 0, tw)
+	rows.append(["GEBMerge", bb, wo, tw, tMerge, tBuild, tSort, tMerge + tBuild + tSort,
+		max(rssMerge, rssBuild)] + counts)
+	if not args.keep:
+		for f in glob.glob(merged + "*") + glob.glob(raw):
+			os.remove(f)
+
+if args.builder:
+	for tw in ints(args.timewin):
+		print("in-memory builder, timewin %d" % tw)
+		tSort, rss, counts = sort(" ".join(data), "builder-%d" % tw, 1, tw)
+		rows.append(["builder", 0, 0, tw, 0.0, 0.0, tSort, tSort, rss] + counts)
+
+# Loss relative to the row that built the most events / kept the most EXE counts
+maxEvents = max([r[9] for r in rows] + [1])
+maxEXE = max([r[11] for r in rows] + [1])
+for r in rows:
+	r += [r[9]/r[7]/1000.0 if r[7] > 0 else 0.0, 1.0 - float(r[9])/maxEvents, 1.0 - float(r[11])/maxEXE]
+
+with open(args.out, "w") as f:
+	f.write("\t".join(columns) + "\n")
+	for r in rows:
+		f.write("\t".join(("%.4g" % x) if isinstance(x, float) else str(x) for x in r) + "\n")
+
+print("\n" + "".join("%-15s" % c for c in columns))
+for r in rows:
+	print("".join(("%-15.4g" % x) if isinstance(x, float) else ("%-15s" % x) for x in r))
+
+subprocess.call(["root", "-l", "-b", "-q", os.path.join(here, 'bench_plot.C("%s","%s")' %
+	(args.out, os.path.splitext(args.out)[0] + ".png"))])
@@ -0,0 +1,138 @@
+// GS_ChannelMap.h
+// Digitizer channel map, loaded from a map.dat file at start-up. The file is flattened into one
+// lookup table indexed directly by the raw channel id, so decoding a hit is a single indexed load
+// (which array, which slot, which sign) rather than a chain of id/detector range tests, and
+// re-cabling only needs map.dat to be edited. See working/map.dat for the file format.
+// Restrict() unmaps the channels of kinds a sort does not keep (inflightSort only keeps TAC and
+// EZERO), so those hits drop out with the unmapped ones and the hit loop has no per-kind tests.
+// ============================================================================================= //
+#ifndef GS_CHANNELMAP_H_
+#define GS_CHANNELMAP_H_
+
+#include "GS_HitList.h"
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TString.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+const Int_t kMaxChannelId = 2000;	// Raw ids are board*10 + channel, all below this
+
+// Kind names used in map.dat and the "kinds=" option, in HitKind order
+const char *const kHitKindNames[kNumHitKinds] = { "E", "XF", "XN", "RDT", "TAC", "ELUM", "EZERO" };
+const UInt_t kAllHitKinds = ( 1 << kNumHitKinds ) - 1;
+
+// Bit mask (1 << HitKind) for a '+'-separated list of kind names, or "all"
+inline UInt_t HitKindMask( const TString &list ){
+	if ( list == "all" ){ return kAllHitKinds; }
+	UInt_t mask = 0;
+	TObjArray *names = list.Tokenize("+");
+	for ( Int_t i = 0; i < names->GetEntries(); i++ ){
+		TString name = ((TObjString*)names->At(i))->GetString();
+		Int_t k = 0;
+		while ( k < kNumHitKinds && name != kHitKindNames[k] ){ k++; }
+		if ( k < kNumHitKinds ){ mask |= ( 1 << k ); }
+		else{ printf("Unknown detector kind \"%s\" (E, XF, XN, RDT, TAC, ELUM, EZERO or all)\n", name.Data() ); }
+	}
+	delete names;
+	return mask;
+}
+
+typedef struct {
+	Char_t  Kind;	// HitKind the channel is stored as, -1 if it is not sorted
+	UChar_t Slot;	// Index in the array of that kind
+	Char_t  Sign;	// +1 for (post_rise - pre_rise), -1 for (pre_rise - post_rise)
+	Bool_t  EBIS;	// Channel also carries the EBIS reference timestamp
+} ChannelMapEntry;
+
+class ChannelMap {
+public:
+	ChannelMapEntry Entry[kMaxChannelId];
+	Int_t           NumChannels;	// Number of mapped lines read
+
+	ChannelMap(){ Clear(); }
+
+	void Clear(){
+		for ( Int_t i = 0; i < kMaxChannelId; i++ ){
+			Entry[i].Kind = -1;
+			Entry[i].Slot = 0;
+			Entry[i].Sign = 1;
+			Entry[i].EBIS = kFALSE;
+		}
+		NumChannels = 0;
+	}
+
+	// Entry for a raw id, or an unmapped entry if the id is out of range
+	const ChannelMapEntry &Get( Int_t id ) const {
+		static const ChannelMapEntry unmapped = { -1, 0, 1, kFALSE };
+		return ( id >= 0 && id < kMaxChannelId ? Entry[id] : unmapped );
+	}
+
+	// Read the map file. Returns kFALSE (after printing the offending line) if it cannot be used.
+	Bool_t Load( const TString &fileName ){
+		Clear();
+		std::ifstream in( fileName.Data() );
+		if ( !in.is_open() ){
+			printf("Cannot open channel map %s\n", fileName.Data() );
+			return kFALSE;
+		}
+
+		std::string line;
+		Int_t lineNum = 0;
+		while ( std::getline( in, line ) ){
+			lineNum++;
+			if ( line.find('#') != std::string::npos ){ line = line.substr( 0, line.find('#') ); }
+			std::istringstream words( line );
+			Int_t id;
+			std::string kind, slot, sign;
+			if ( !( words >> id ) ){ continue; }	// Blank or comment line
+			if ( !( words >> kind ) || id < 0 || id >= kMaxChannelId ){
+				printf("Bad line %d in channel map %s: %s\n", lineNum, fileName.Data(), line.c_str() );
+				return kFALSE;
+			}
+
+			if ( kind == "EBIS" ){
+				Entry[id].EBIS = kTRUE;
+				NumChannels++;
+				continue;
+			}
+
+			Int_t k = -1;
+			for ( Int_t i = 0; i < kNumHitKinds; i++ ){
+				if ( kind == kHitKindNames[i] ){ k = i; }
+			}
+			Int_t s = -1, sg = 0;
+			if ( words >> slot >> sign ){
+				s = atoi( slot.c_str() );
+				sg = atoi( sign.c_str() );
+			}
+			if ( k < 0 || s < 0 || s >= kHitKindSize[k] || ( sg != 1 && sg != -1 ) ){
+				printf("Bad line %d in channel map %s: %s\n", lineNum, fileName.Data(), line.c_str() );
+				return kFALSE;
+			}
+			Entry[id].Kind = k;
+			Entry[id].Slot = s;
+			Entry[id].Sign = sg;
+			NumChannels++;
+		}
+		printf("Read %d channels from %s\n", NumChannels, fileName.Data() );
+		return kTRUE;
+	}
+
+	// Unmap the channels of kinds not in kindMask (their EBIS flag is kept). Returns the number
+	// of channels left sorted.
+	Int_t Restrict( UInt_t kindMask ){
+		Int_t kept = 0;
+		for ( Int_t i = 0; i < kMaxChannelId; i++ ){
+			if ( Entry[i].Kind < 0 ){ continue; }
+			if ( kindMask & ( 1 << Entry[i].Kind ) ){ kept++; }
+			else{ Entry[i].Kind = -1; }
+		}
+		return kept;
+	}
+};
+
+#endif
@@ -0,0 +1,212 @@
+// GS_ChannelRates.h
+// Per-channel rates, dead time and pile-up in fixed time buckets, accumulated by GeneralSort in
+// the same pass as the sort and written as the small rate_tree next to gen_tree, so that rate
+// and normalisation studies do not need a TTree::Draw pass over the whole gen_tree. Each entry is
+// one channel in one bucket of "ratebin=" seconds (1 by default) of digitizer time:
+//   t/D        start of the bucket, in seconds of timestamp (absolute)
+//   id/S       raw channel id
+//   counts/I   hits of the channel in the bucket seen by the sort
+//   rate/F     hits per second
+//   dead/F     fraction of the bucket the channel was busy: each hit counts as busy for
+//              "deadtime=" ticks (100 by default) or until the next hit of the channel if sooner
+//   pileup/F   fraction of the hits with the digitizer pile-up flag (0 without the flags)
+//   close/F    fraction of the hits within deadtime= of the previous hit of the channel
+//   edge/b     1 for the first bucket of the sort, 2 for the last: the sort may have started or
+//              stopped partway through it, so it may hold only part of the bucket
+// Hits that arrive for an earlier bucket (out of order by less than the event window) are counted
+// in the current one. e.g. rate_tree->Draw("rate:t","id==1011 && edge==0","l")
+// In a quick look (GS_QuickLook.h) rate, dead and close are scaled by the quick-look factor to
+// estimate those of the full run (dead and close to first order, capped at 1), counts is not.
+// A bucket split between two GeneralSortMT slices is in both of their rate_trees, at the edge of
+// each. JoinEdges() sums the two halves of every such bucket once the slices are merged.
+// ============================================================================================= //
+#ifndef GS_CHANNELRATES_H_
+#define GS_CHANNELRATES_H_
+
+#include "GS_ChannelMap.h"
+#include "GS_Options.h"
+#include <TDirectory.h>
+#include <TMath.h>
+#include <TString.h>
+#include <TTree.h>
+#include <map>
+#include <vector>
+
+class ChannelRates {
+public:
+	Double_t Width;			// Bucket width in seconds, "ratebin="
+	Long64_t DeadTicks;		// Busy time after each hit, "deadtime="
+	Double_t Tick;			// Length of one timestamp count in seconds
+	Double_t Scale;			// Quick-look factor to the full run
+	TTree   *Tree;
+
+	ChannelRates() : Width(1), DeadTicks(100), Tick(1e-8), Scale(1), Tree(0), fBucket(-1), fEdge(1), fNumTouched(0){
+		for ( Int_t i = 0; i < kMaxChannelId; i++ ){
+			fCounts[i] = fPileup[i] = fClose[i] = 0;
+			fBusy[i] = 0;
+			fLast[i] = 0;
+			fSeen[i] = kFALSE;
+		}
+	}
+
+	void Configure( const TString &option ){
+		Width = GetOptionValue( option, "ratebin", "1" ).Atof();
+		DeadTicks = GetOptionValue( option, "deadtime", "100" ).Atoll();
+		if ( Width <= 0 ){ Width = 1; }
+	}
+
+	// Book rate_tree in the current directory (the output file)
+	void Book(){
+		Tree = new TTree( "rate_tree", "Channel rates per time bucket" );
+		Tree->Branch( "t", &fT, "t/D" );
+		Tree->Branch( "id", &fId, "id/S" );
+		Tree->Branch( "counts", &fN, "counts/I" );
+		Tree->Branch( "rate", &fRate, "rate/F" );
+		Tree->Branch( "dead", &fDead, "dead/F" );
+		Tree->Branch( "pileup", &fPileupFrac, "pileup/F" );
+		Tree->Branch( "close", &fCloseFrac, "close/F" );
+		Tree->Branch( "edge", &fEdge, "edge/b" );
+	}
+
+	// Count one hit
+	void Fill( Int_t id, ULong64_t timestamp, Bool_t pileup ){
+		if ( id < 0 || id >= kMaxChannelId ){ return; }
+		Long64_t bucket = (Long64_t)( timestamp*Tick/Width );
+		if ( bucket > fBucket ){
+			Flush();
+			fBucket = bucket;
+		}
+
+		if ( fCounts[id] == 0 ){ fTouched[ fNumTouched++ ] = id; }
+		fCounts[id]++;
+		fPileup[id] += pileup;
+		Long64_t gap = ( fSeen[id] ? (Long64_t)( timestamp - fLast[id] ) : DeadTicks );
+		if ( gap < 0 ){ gap = 0; }
+		fClose[id] += ( gap < DeadTicks );
+		fBusy[id] += ( gap < DeadTicks ? gap : DeadTicks );
+		fLast[id] = timestamp;
+		fSeen[id] = kTRUE;
+	}
+
+	// Fill rate_tree with the channels of the current bucket
+	void Flush(){
+		if ( Tree == NULL ){ return; }
+		fT = fBucket*Width;
+		for ( Int_t j = 0; j < fNumTouched; j++ ){
+			Int_t i = fTouched[j];
+			fId = i;
+			fN = fCounts[i];
+			fRate = fN*Scale/Width;
+			fDead = TMath::Min( 1.0, fBusy[i]*Tick/Width*Scale );
+			fPileupFrac = (Float_t)fPileup[i]/fN;
+			fCloseFrac = TMath::Min( 1.0, (Double_t)fClose[i]/fN*Scale );
+			Tree->Fill();
+			fCounts[i] = fPileup[i] = fClose[i] = 0;
+			fBusy[i] = 0;
+		}
+		if ( fNumTouched > 0 ){ fEdge = 0; }
+		fNumTouched = 0;
+	}
+
+	// Flush the last bucket and write rate_tree into its file
+	void Write(){
+		if ( Tree == NULL ){ return; }
+		fEdge |= 2;
+		Flush();
+		Tree->Write( "", TObject::kOverwrite );
+	}
+
+	// Rewrite the rate_tree of dir (the file the GeneralSortMT slices were merged into), summing
+	// the halves of the buckets split between two slices: a bucket that is the last of one slice
+	// (edge 2) and the first of another (edge 1) is complete, each channel in it gets one entry
+	// and edge 0. Returns the number of buckets joined.
+	Long64_t JoinEdges( TDirectory *dir ){
+		TTree *in = (TTree*)dir->Get("rate_tree");
+		if ( in == NULL || in->GetBranch("edge") == NULL ){ return 0; }
+		in->SetBranchAddress( "t", &fT );
+		in->SetBranchAddress( "id", &fId );
+		in->SetBranchAddress( "counts", &fN );
+		in->SetBranchAddress( "rate", &fRate );
+		in->SetBranchAddress( "dead", &fDead );
+		in->SetBranchAddress( "pileup", &fPileupFrac );
+		in->SetBranchAddress( "close", &fCloseFrac );
+		in->SetBranchAddress( "edge", &fEdge );
+
+		// Read it all (it is small) and find the buckets with both halves
+		std::vector<RateEntry> entries( in->GetEntries() );
+		std::map<Double_t,UChar_t> edges;
+		for ( Long64_t i = 0; i < in->GetEntries(); i++ ){
+			in->GetEntry(i);
+			RateEntry e = { fT, fId, fN, fRate, fDead, fPileupFrac, fCloseFrac, fEdge };
+			entries[i] = e;
+			if ( fEdge == 1 || fEdge == 2 ){ edges[fT] |= fEdge; }	// 3 is a slice within one bucket
+		}
+		delete in;
+		Long64_t numJoined = 0;
+		for ( std::map<Double_t,UChar_t>::iterator b = edges.begin(); b != edges.end(); ++b ){ numJoined += ( b->second == 3 ); }
+		if ( numJoined == 0 ){ return 0; }
+
+		// Sum the entries of each channel in a joined bucket into the first of them
+		std::map< std::pair<Double_t,Short_t>, Long64_t > first;
+		std::vector<Bool_t> keep( entries.size(), kTRUE );
+		for ( UInt_t i = 0; i < entries.size(); i++ ){
+			RateEntry &e = entries[i];
+			if ( e.Edge == 0 || edges[e.T] != 3 ){ continue; }
+			std::pair<Double_t,Short_t> key( e.T, e.Id );
+			if ( first.count( key ) == 0 ){
+				first[key] = i;
+				e.Edge = 0;
+				continue;
+			}
+			RateEntry &sum = entries[ first[key] ];
+			Int_t n = sum.Counts + e.Counts;
+			sum.Pileup = ( sum.Pileup*sum.Counts + e.Pileup*e.Counts )/n;
+			sum.Close = ( sum.Close*sum.Counts + e.Close*e.Counts )/n;
+			sum.Counts = n;
+			sum.Rate += e.Rate;
+			sum.Dead = TMath::Min( 1.0f, sum.Dead + e.Dead );
+			keep[i] = kFALSE;
+		}
+
+		dir->Delete("rate_tree;*");
+		dir->cd();
+		Book();
+		for ( UInt_t i = 0; i < entries.size(); i++ ){
+			if ( !keep[i] ){ continue; }
+			const RateEntry &e = entries[i];
+			fT = e.T; fId = e.Id; fN = e.Counts; fRate = e.Rate; fDead = e.Dead;
+			fPileupFrac = e.Pileup; fCloseFrac = e.Close; fEdge = e.Edge;
+			Tree->Fill();
+		}
+		Tree->Write( "", TObject::kOverwrite );
+		return numJoined;
+	}
+
+private:
+	typedef struct {
+		Double_t T;
+		Short_t  Id;
+		Int_t    Counts;
+		Float_t  Rate, Dead, Pileup, Close;
+		UChar_t  Edge;
+	} RateEntry;
+
+	Long64_t  fBucket;		// Index of the current bucket, -1 before the first hit
+	Int_t     fCounts[kMaxChannelId];
+	Int_t     fPileup[kMaxChannelId];
+	Int_t     fClose[kMaxChannelId];
+	Long64_t  fBusy[kMaxChannelId];		// Ticks
+	ULong64_t fLast[kMaxChannelId];		// Last timestamp of each channel
+	Bool_t    fSeen[kMaxChannelId];
+	Int_t     fTouched[kMaxChannelId];	// Channels with hits in the current bucket
+	Int_t     fNumTouched;
+
+	// rate_tree entry
+	Double_t fT;
+	Short_t  fId;
+	Int_t    fN;
+	Float_t  fRate, fDead, fPileupFrac, fCloseFrac;
+	UChar_t  fEdge;			// See edge/b above: 1 until the first bucket is flushed, 2 in Write
+};
+
+#endif
@@ -0,0 +1,105 @@
+// GS_DecodeThread.h
+// Decodes one GEB stream on its own thread, for GS_EventBuilder.h with Threads set. The worker
+// reads and decodes the file with a GEBReader and hands the hits over in blocks through a short
+// bounded queue, so the reading, byte-swapping and decoding of every digitizer file of a run go on
+// at the same time and the wall time is set by the slowest file rather than by their sum. The
+// queue bound keeps memory at maxBlocks*blockSize hits per stream however far ahead a file gets.
+// Next() has the same meaning as GEBReader::Next() for a file that is not being followed.
+// ============================================================================================= //
+#ifndef GS_DECODETHREAD_H_
+#define GS_DECODETHREAD_H_
+
+#include "GS_GEBReader.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class GEBDecodeThread {
+public:
+	GEBReader Reader;		// Used by the worker. Its counts are final once the stream is done.
+
+	GEBDecodeThread( UInt_t blockSize = 4096, UInt_t maxBlocks = 16 ) : fBlockSize(blockSize),
+		fMaxBlocks(maxBlocks), fPos(0), fDone(kFALSE), fStop(kFALSE) {}
+	~GEBDecodeThread(){ Stop(); }
+
+	Bool_t Open( const TString &fileName, Bool_t followChunks ){ return Reader.Open( fileName, followChunks ); }
+
+	// Start decoding in the background
+	void Start(){ fThread = std::thread( &GEBDecodeThread::Run, this ); }
+
+	// Next hit of the stream, waiting for the worker if need be. kFALSE at the end of the stream.
+	Bool_t Next( GEBHit &hit ){
+		if ( fPos >= fBlock.size() ){
+			std::unique_lock<std::mutex> lock( fMutex );
+			fReady.wait( lock, [this]{ return ( !fQueue.empty() || fDone ); } );
+			if ( fQueue.empty() ){ return kFALSE; }
+			fBlock.swap( fQueue.front() );
+			fQueue.pop_front();
+			fPos = 0;
+			fSpace.notify_one();
+		}
+		hit = fBlock[ fPos++ ];
+		return kTRUE;
+	}
+
+	// kFALSE once every hit has been handed out
+	Bool_t IsOpen(){
+		if ( fPos < fBlock.size() ){ return kTRUE; }
+		std::lock_guard<std::mutex> lock( fMutex );
+		return ( !fDone || !fQueue.empty() );
+	}
+
+	// Stop the worker (if it is still running) and wait for it
+	void Stop(){
+		{
+			std::lock_guard<std::mutex> lock( fMutex );
+			fStop = kTRUE;
+		}
+		fSpace.notify_all();
+		if ( fThread.joinable() ){ fThread.join(); }
+	}
+
+private:
+	typedef std::vector<GEBHit> Block;
+
+	UInt_t                  fBlockSize;
+	UInt_t                  fMaxBlocks;
+	Block                   fBlock;		// Block being handed out (consumer side)
+	UInt_t                  fPos;
+	std::deque<Block>       fQueue;		// Decoded blocks waiting for the consumer
+	Bool_t                  fDone;		// The worker has queued its last block
+	Bool_t                  fStop;
+	std::mutex              fMutex;
+	std::condition_variable fReady;		// A block was queued, or the worker is done
+	std::condition_variable fSpace;		// A block was taken, or Stop() was called
+	std::thread             fThread;
+
+	void Run(){
+		Block block;
+		block.reserve( fBlockSize );
+		GEBHit hit;
+		Bool_t more = kTRUE;
+		while ( more ){
+			more = Reader.Next( hit );
+			if ( more ){ block.push_back( hit ); }
+			if ( block.size() < fBlockSize && ( more || block.empty() ) ){ continue; }
+
+			std::unique_lock<std::mutex> lock( fMutex );
+			fSpace.wait( lock, [this]{ return ( fQueue.size() < fMaxBlocks || fStop ); } );
+			if ( fStop ){ break; }
+			fQueue.push_back( Block() );
+			fQueue.back().swap( block );
+			block.reserve( fBlockSize );
+			fReady.notify_one();
+		}
+		Reader.Close();
+
+		std::lock_guard<std::mutex> lock( fMutex );
+		fDone = kTRUE;
+		fReady.notify_all();
+	}
+};
+
+#endif
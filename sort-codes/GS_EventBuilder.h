@@ -0,0 +1,281 @@
+// GS_EventBuilder.h
+// Timestamp event builder over several GEB streams, used by GeneralSortGEB.C in place of the
+// GEBMerge buffering stage. Each input file (one per digitizer/IOC, or a single GEBMerged file)
+// is a stream whose next hit sits in a min-heap keyed on timestamp, so hits come out of the
+// k-way merge in time order and only one hit per stream is held at a time. Events are built the
+// way GEBSort does: an event is closed once the next hit is more than Window ticks after the
+// first hit of the event (timewin in GEBSort.chat).
+//
+// Streams are expected to be time-ordered. With Lookahead > 0 each stream is also passed through
+// its own reorder buffer holding Lookahead ticks of data, which absorbs local disorder within a
+// file. Memory therefore scales with the number of streams and the time windows, not with a
+// buffer size as in GEBMerge's bigbufsize/wosize. A hit still earlier than an event that has
+// already been handed out cannot be used and is counted in NumDropped.
+//
+// With Follow set the files are tailed while they are still being written (GeneralSortOnline.C).
+// A stream that has run dry but is still open holds the merge back, as its next hit could be the
+// earliest, and NextEvent returns -1 until there is more data (or Finish() is called). A stream
+// that stays dry for StallTime ms (a digitizer that has gone quiet) stops holding it back: the
+// other streams are built without it, and once it has data again it rejoins the merge, its hits
+// from before the events already built being counted in NumDropped.
+//
+// With Threads set (and not Follow) every stream is read and decoded on its own thread
+// (GS_DecodeThread.h) and only the merge and event building are done here, so the digitizer
+// files of a run are decoded at the same time rather than one after the other.
+// ============================================================================================= //
+#ifndef GS_EVENTBUILDER_H_
+#define GS_EVENTBUILDER_H_
+
+#include "GS_DecodeThread.h"
+#include "GS_GEBReader.h"
+#include <queue>
+#include <vector>
+
+// Orders hits (and stream heads) so that the earliest timestamp is at the top of a heap
+struct GEBHitLater {
+	Bool_t operator()( const GEBHit &a, const GEBHit &b ) const { return a.Timestamp > b.Timestamp; }
+};
+
+typedef std::priority_queue< GEBHit, std::vector<GEBHit>, GEBHitLater > GEBHitHeap;
+
+class EventBuilder {
+public:
+	ULong64_t Window;		// Coincidence window in timestamp ticks
+	ULong64_t Lookahead;	// Per-stream reorder depth in ticks, 0 = trust the stream order
+
+	Long64_t NumHits;			// Hits read from all streams
+	Long64_t NumEvents;			// Events handed out
+	Long64_t NumOutOfOrder;		// Hits earlier than the previous hit of their own stream
+	Long64_t NumDropped;		// Hits earlier than an event that had already been built
+	Long64_t NumOverflow;		// Hits beyond the maxHits of an event
+	Bool_t   Follow;			// Tail growing files, see above. Set before AddFile.
+	Bool_t   Threads;			// Decode each stream on its own thread. Set before AddFile.
+	Long64_t StallTime;			// ms a dry stream holds back the others when following, <0 for ever
+	Long64_t NumStalls;			// Times a stream was left behind after StallTime
+
+	EventBuilder( ULong64_t window = 1000, ULong64_t lookahead = 0 ) : Window(window), Lookahead(lookahead),
+		NumHits(0), NumEvents(0), NumOutOfOrder(0), NumDropped(0), NumOverflow(0), Follow(kFALSE),
+		Threads(kFALSE), StallTime(10000), NumStalls(0), fHaveNext(kFALSE), fInEvent(kFALSE), fEventStart(0), fLastStart(0), fStarted(kFALSE),
+		fStopped(kFALSE) {}
+
+	~EventBuilder(){
+		for ( UInt_t i = 0; i < fStreams.size(); i++ ){ delete fStreams[i]; }
+	}
+
+	// Add one input file as a stream. Call for every file before the first NextEvent. With
+	// followChunks the _001, _002, ... files after it are read as part of the same stream.
+	Bool_t AddFile( const TString &fileName, Bool_t followChunks = kFALSE ){
+		Stream *s = new Stream;
+		s->Name = fileName;
+		s->Reader.Follow = Follow;
+		if ( Threads && !Follow ){ s->Decoder = new GEBDecodeThread; }
+		if ( !( s->Decoder ? s->Decoder->Open( fileName, followChunks ) : s->Reader.Open( fileName, followChunks ) ) ){
+			delete s;
+			return kFALSE;
+		}
+		fStreams.push_back( s );
+		return kTRUE;
+	}
+
+	Int_t GetNumStreams() const { return fStreams.size(); }
+
+	// Copy the hits of the next event into hits (at most maxHits of them, the rest are counted
+	// in NumOverflow). Returns the number of hits, 0 once every stream is exhausted, or -1 when
+	// following growing files and the next event is not complete yet.
+	Int_t NextEvent( GEBHit *hits, Int_t maxHits ){
+		if ( !fStarted ){ Start(); }
+
+		while ( kTRUE ){
+			if ( !Peek() ){
+				if ( !Finished() ){ return -1; }
+				if ( !fInEvent ){ return 0; }
+				return EndEvent( hits );	// Last event of the run
+			}
+
+			if ( !fInEvent ){
+				// Skip any hits that belong to events already built
+				if ( fNext.Timestamp < fLastStart ){
+					NumDropped++;
+					fHaveNext = kFALSE;
+					continue;
+				}
+				fInEvent = kTRUE;
+				fEventStart = fNext.Timestamp;
+				fEvent.clear();
+			}
+
+			// The first hit outside the window closes the event (and opens the next one)
+			if ( fNext.Timestamp - fEventStart > Window ){ return EndEvent( hits ); }
+
+			if ( (Int_t)fEvent.size() < maxHits ){ fEvent.push_back( fNext ); }
+			else { NumOverflow++; }
+			fHaveNext = kFALSE;
+		}
+	}
+
+	// Stop following the files: what is already on disk is still read and built into events,
+	// after which NextEvent returns 0
+	void Finish(){
+		for ( UInt_t i = 0; i < fStreams.size(); i++ ){
+			fStreams[i]->Reader.Follow = kFALSE;
+		}
+	}
+
+	// Stop reading before the end of the files (e.g. max= reached). The decoding threads are
+	// stopped and joined, so that their record counts can be read.
+	void Stop(){
+		for ( UInt_t i = 0; i < fStreams.size(); i++ ){
+			if ( !fStreams[i]->Done ){ fStopped = kTRUE; }
+			if ( fStreams[i]->Decoder ){ fStreams[i]->Decoder->Stop(); }
+		}
+	}
+
+	// Call Stop() first if the build ended before the end of the files
+	void PrintSummary() const {
+		Long64_t numRecords = 0, numSkipped = 0;
+		for ( UInt_t i = 0; i < fStreams.size(); i++ ){
+			const GEBReader &r = fStreams[i]->Source();
+			numRecords += r.NumRecords;
+			numSkipped += r.NumSkipped;
+		}
+		printf("Event builder: %d streams%s, window %llu, lookahead %llu\n", GetNumStreams(),
+			( Threads && !Follow ? " (one decoding thread each)" : "" ), Window, Lookahead );
+		printf("  %lld GEB records%s (%lld not digitizer hits), %lld hits, %lld events\n", numRecords,
+			( fStopped ? " read before the build stopped" : "" ), numSkipped, NumHits, NumEvents );
+		printf("  %lld out of order within a stream, %lld dropped as too late, %lld over the event size\n",
+			NumOutOfOrder, NumDropped, NumOverflow );
+		if ( NumStalls ){ printf("  %lld times a stream had no data for %lld ms and was left behind\n", NumStalls, StallTime ); }
+	}
+
+private:
+	struct Stream {
+		GEBReader        Reader;
+		GEBDecodeThread *Decoder;	// Reads the file instead of Reader when Threads is set
+		GEBHitHeap       Buffer;	// Hits read ahead, earliest on top
+		ULong64_t        LastRead;	// Latest timestamp read from the file
+		Bool_t           Done;
+		TString          Name;		// File given to AddFile, for the messages
+		Long64_t         DrySince;	// gSystem->Now() when it ran dry (Follow), 0 while it has data
+		Bool_t           Stalled;	// Dry for StallTime, no longer holding back the merge
+		Stream() : Decoder(NULL), LastRead(0), Done(kFALSE), DrySince(0), Stalled(kFALSE) {}
+		~Stream(){ delete Decoder; }
+
+		Bool_t Next( GEBHit &hit ){ return ( Decoder ? Decoder->Next( hit ) : Reader.Next( hit ) ); }
+		Bool_t IsOpen(){ return ( Decoder ? Decoder->IsOpen() : Reader.IsOpen() ); }
+		const GEBReader &Source() const { return ( Decoder ? Decoder->Reader : Reader ); }
+	};
+
+	// Heap entry for a stream: its earliest buffered hit
+	struct Head {
+		ULong64_t Timestamp;
+		Int_t     Index;
+		Bool_t operator<( const Head &h ) const { return Timestamp > h.Timestamp; }
+	};
+
+	std::vector<Stream*>      fStreams;
+	std::priority_queue<Head> fHeads;
+	std::vector<Int_t>        fWaiting;		// Open streams with nothing buffered (Follow only)
+	GEBHit                    fNext;		// Earliest hit over all streams
+	Bool_t                    fHaveNext;
+	std::vector<GEBHit>       fEvent;		// Event being built
+	Bool_t                    fInEvent;
+	ULong64_t                 fEventStart;	// First timestamp of the event being built
+	ULong64_t                 fLastStart;	// First timestamp of the last event built
+	Bool_t                    fStarted;
+	Bool_t                    fStopped;		// Stop() was called before the end of the files
+
+	// Read from the file until the stream buffer covers Lookahead ticks past its earliest hit
+	void Fill( Stream *s ){
+		GEBHit hit;
+		while ( !s->Done && ( s->Buffer.empty() || s->LastRead < s->Buffer.top().Timestamp + Lookahead ) ){
+			if ( !s->Next( hit ) ){
+				if ( !s->IsOpen() ){ s->Done = kTRUE; }	// Otherwise waiting for more data
+				break;
+			}
+			NumHits++;
+			if ( hit.Timestamp < s->LastRead ){ NumOutOfOrder++; }
+			else { s->LastRead = hit.Timestamp; }
+			s->Buffer.push( hit );
+		}
+	}
+
+	// Put a stream back in the heap, or on the waiting list if it is open but has run dry
+	void PushHead( Int_t i ){
+		if ( fStreams[i]->Buffer.empty() ){
+			if ( !fStreams[i]->Done ){ fWaiting.push_back( i ); }
+			return;
+		}
+		fStreams[i]->DrySince = 0;
+		fStreams[i]->Stalled = kFALSE;
+		Head h = { fStreams[i]->Buffer.top().Timestamp, i };
+		fHeads.push( h );
+	}
+
+	void Start(){
+		for ( UInt_t i = 0; i < fStreams.size(); i++ ){
+			if ( fStreams[i]->Decoder ){ fStreams[i]->Decoder->Start(); }
+		}
+		for ( UInt_t i = 0; i < fStreams.size(); i++ ){
+			Fill( fStreams[i] );
+			PushHead( i );
+		}
+		fStarted = kTRUE;
+	}
+
+	Bool_t Finished() const { return ( !fHaveNext && fHeads.empty() && fWaiting.empty() ); }
+
+	// Make fNext the earliest remaining hit. Returns kFALSE if there is none (yet).
+	Bool_t Peek(){
+		if ( fHaveNext ){ return kTRUE; }
+
+		// Streams that ran dry have to be topped up before anything can be taken from the heap
+		if ( !fWaiting.empty() ){
+			std::vector<Int_t> waiting;
+			waiting.swap( fWaiting );
+			for ( UInt_t j = 0; j < waiting.size(); j++ ){
+				Fill( fStreams[ waiting[j] ] );
+				PushHead( waiting[j] );
+			}
+			if ( !fWaiting.empty() && ( fHeads.empty() || HeldBack() ) ){ return kFALSE; }
+		}
+		if ( fHeads.empty() ){ return kFALSE; }
+
+		Int_t i = fHeads.top().Index;
+		fHeads.pop();
+		Stream *s = fStreams[i];
+		fNext = s->Buffer.top();
+		s->Buffer.pop();
+		fHaveNext = kTRUE;
+		Fill( s );
+		PushHead( i );
+		return kTRUE;
+	}
+
+	// Whether a dry stream still holds back the merge, i.e. has been dry for less than StallTime
+	Bool_t HeldBack(){
+		if ( !Follow || StallTime < 0 ){ return kTRUE; }
+		Long64_t now = (Long64_t)gSystem->Now();
+		Bool_t held = kFALSE;
+		for ( UInt_t j = 0; j < fWaiting.size(); j++ ){
+			Stream *s = fStreams[ fWaiting[j] ];
+			if ( s->DrySince == 0 ){ s->DrySince = now; }
+			if ( now - s->DrySince < StallTime ){ held = kTRUE; }
+			else if ( !s->Stalled ){
+				s->Stalled = kTRUE;
+				NumStalls++;
+				printf("No data from %s for %.1f s, building events without it\n", s->Name.Data(), StallTime/1000.0 );
+			}
+		}
+		return held;
+	}
+
+	Int_t EndEvent( GEBHit *hits ){
+		for ( UInt_t i = 0; i < fEvent.size(); i++ ){ hits[i] = fEvent[i]; }
+		fInEvent = kFALSE;
+		fLastStart = fEventStart;
+		NumEvents++;
+		return fEvent.size();
+	}
+};
+
+#endif
@@ -0,0 +1,175 @@
+// GS_GEBReader.h
+// Reader for the GEB (.gtd) files written by the digitizer readout and by GEBMerge, so that
+// GeneralSort can be fed straight from GEBMerged_run###.gtd_### without GEBSort_nogeb writing
+// the full 38-branch raw tree first. Every record is a 16 byte GEB header
+//   type/I, length/I (payload bytes), timestamp/L
+// followed by the payload. Digitizer (DGS) payloads are big-endian 32-bit words, and only the
+// fields GeneralSort uses are decoded from them:
+//   id              = board_id*10 + chan_id, board_id = (w0>>4)&0xfff, chan_id = w0&0xf
+//   event_timestamp = w1 | (w2&0xffff)<<32
+//   pre_rise_energy = w7&0xffffff
+//   post_rise_energy= (w7>>24)&0xff | (w8&0xffff)<<8
+// which is the same unpacking GEBSort_nogeb does when it fills the raw tree. Records of any
+// other GEB type are counted and skipped.
+//
+// With Follow set the reader tails a file that is still being written (GeneralSortOnline.C):
+// at the end of the data, or part way through a record, Next() goes back to the start of the
+// record and returns kFALSE with the file left open (IsOpen()), to be called again later.
+// ============================================================================================= //
+#ifndef GS_GEBREADER_H_
+#define GS_GEBREADER_H_
+
+#include <TString.h>
+#include <TSystem.h>
+#include <cstdio>
+#include <vector>
+
+const Int_t kGEBTypeDGS = 14;		// GEB_TYPE_DGS in GEBSort's gdecomp.h
+const Int_t kGEBHeaderBytes = 16;
+const Int_t kGEBMinDGSWords = 9;	// Words needed to reach the post-rise energy
+
+// One decoded digitizer hit: the raw tree fields GeneralSort reads
+typedef struct {
+	Short_t   Id;
+	Int_t     PreRise;
+	Int_t     PostRise;
+	ULong64_t Timestamp;
+} GEBHit;
+
+inline UInt_t GEBSwap( UInt_t w ){
+	return ( ( w >> 24 ) & 0xff ) | ( ( w >> 8 ) & 0xff00 ) | ( ( w << 8 ) & 0xff0000 ) | ( w << 24 );
+}
+
+// Decode the DGS payload words (still big-endian) into hit. Returns kFALSE if it is too short.
+inline Bool_t DecodeDGS( const UInt_t *payload, Int_t numWords, GEBHit &hit ){
+	if ( numWords < kGEBMinDGSWords ){ return kFALSE; }
+	UInt_t w0 = GEBSwap( payload[0] ), w1 = GEBSwap( payload[1] ), w2 = GEBSwap( payload[2] );
+	UInt_t w7 = GEBSwap( payload[7] ), w8 = GEBSwap( payload[8] );
+	hit.Id = ( ( w0 >> 4 ) & 0xfff )*10 + ( w0 & 0xf );
+	hit.Timestamp = (ULong64_t)w1 | ( (ULong64_t)( w2 & 0xffff ) << 32 );
+	hit.PreRise = w7 & 0xffffff;
+	hit.PostRise = ( ( w7 >> 24 ) & 0xff ) | ( ( w8 & 0xffff ) << 8 );
+	return kTRUE;
+}
+
+class GEBReader {
+public:
+	Long64_t NumRecords;	// GEB records read
+	Long64_t NumSkipped;	// Records that were not digitizer hits (or were too short)
+	Bool_t   Follow;		// Wait at the end of the file for more data rather than closing it
+
+	GEBReader() : NumRecords(0), NumSkipped(0), Follow(kFALSE), fFile(NULL), fChunk(-1) {}
+	~GEBReader(){ Close(); }
+
+	// Open a .gtd file. GEBMerge splits its output into _000, _001, ... chunks: given either the
+	// name of a chunk or the name without the suffix, the following chunks are read in turn
+	// (unless followChunks is kFALSE, when only the file given is read).
+	Bool_t Open( const TString &fileName, Bool_t followChunks = kTRUE ){
+		Close();
+		fBase = fileName;
+		fChunk = -1;
+		if ( !followChunks ){
+			if ( !OpenChunk() ){
+				printf("Cannot open GEB file %s\n", fileName.Data() );
+				return kFALSE;
+			}
+			return kTRUE;
+		}
+		TString suffix = ( fileName.Length() > 4 ? fileName( fileName.Length() - 4, 4 ) : "" );
+		if ( suffix.BeginsWith("_") && TString( suffix(1,3) ).IsDigit() ){
+			fBase = fileName( 0, fileName.Length() - 4 );
+			fChunk = TString( suffix(1,3) ).Atoi();
+		}
+		else if ( gSystem->AccessPathName( fileName ) && !gSystem->AccessPathName( fileName + "_000" ) ){
+			fChunk = 0;
+		}
+		if ( !OpenChunk() ){
+			printf("Cannot open GEB file %s\n", fileName.Data() );
+			return kFALSE;
+		}
+		return kTRUE;
+	}
+
+	void Close(){
+		if ( fFile ){ fclose( fFile ); }
+		fFile = NULL;
+	}
+
+	Bool_t IsOpen() const { return ( fFile != NULL ); }
+
+	// Read up to the next digitizer hit. Returns kFALSE at the end of the last chunk, or (with
+	// Follow) when no complete record has been written yet.
+	Bool_t Next( GEBHit &hit ){
+		Int_t header[4];	// type, length, timestamp (2 words)
+		Bool_t reread = kFALSE;
+		while ( fFile ){
+			Long64_t pos = ftello( fFile );
+			if ( fread( header, 1, kGEBHeaderBytes, fFile ) != (size_t)kGEBHeaderBytes ){
+				if ( Follow ){
+					// Wait for the writer, unless it has moved on to the next chunk. In that case
+					// this chunk was complete, so read from the same place once more before leaving it.
+					fseeko( fFile, pos, SEEK_SET );
+					Bool_t nextChunk = ( fChunk >= 0 && !gSystem->AccessPathName( ChunkName( fChunk + 1 ) ) );
+					if ( !nextChunk ){ return kFALSE; }
+					if ( !reread ){
+						reread = kTRUE;
+						continue;
+					}
+				}
+				// End of this chunk, carry on with the next one if there is one
+				reread = kFALSE;
+				Close();
+				if ( fChunk >= 0 ){
+					fChunk++;
+					OpenChunk();
+				}
+				continue;
+			}
+			Int_t type = header[0], length = header[1];
+			if ( length < 0 ){
+				printf("Corrupt GEB record (length %d) in %s, stopping\n", length, CurrentName().Data() );
+				Close();
+				return kFALSE;
+			}
+			fPayload.resize( ( length + 3 )/4 );
+			if ( length > 0 && fread( &fPayload[0], 1, length, fFile ) != (size_t)length ){
+				if ( Follow ){
+					fseeko( fFile, pos, SEEK_SET );
+					return kFALSE;
+				}
+				printf("Truncated GEB record at the end of %s\n", CurrentName().Data() );
+				Close();
+				return kFALSE;
+			}
+			NumRecords++;
+			if ( type != kGEBTypeDGS || !DecodeDGS( &fPayload[0], length/4, hit ) ){
+				NumSkipped++;
+				continue;
+			}
+			return kTRUE;
+		}
+		return kFALSE;
+	}
+
+private:
+	FILE                *fFile;
+	TString              fBase;		// File name without the chunk suffix
+	Int_t                fChunk;	// Current chunk number, -1 for a file that is not split
+	std::vector<UInt_t>  fPayload;
+
+	TString ChunkName( Int_t chunk ) const {
+		return TString::Format( "%s_%03d", fBase.Data(), chunk );
+	}
+
+	TString CurrentName() const {
+		return ( fChunk >= 0 ? ChunkName( fChunk ) : fBase );
+	}
+
+	Bool_t OpenChunk(){
+		fFile = fopen( CurrentName().Data(), "rb" );
+		if ( fFile ){ setvbuf( fFile, NULL, _IOFBF, 1 << 22 ); }
+		return ( fFile != NULL );
+	}
+};
+
+#endif
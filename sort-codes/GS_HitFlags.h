@@ -0,0 +1,121 @@
+// GS_HitFlags.h
+// Status flags of the digitizer hits, for GeneralSort to drop or mark bad hits when they are
+// decoded rather than in PTMonitors or AnalyseTree. The raw tree flags of each hit are folded
+// into one bit mask:
+//   pileup   pileup_flag set
+//   peak     peak_valid_flag not set (no valid peak found)
+//   offset   offset_flag set
+//   sync     sync_error_flag set
+//   error    general_error_flag set
+// Lists of these names joined by '+' (or "all") are given with the options
+//   reject=sync+error     hits with any of these flags are not sorted at all
+//   tag=pileup+peak       hits are sorted, and their flags written with them (e_flag, hit_flag, ...)
+// HitFlagMonitor counts the hits and each flag per raw channel id for the run. It is written as
+// the hFlags histogram (merges like the other histograms) and printed as a table of rates.
+// ============================================================================================= //
+#ifndef GS_HITFLAGS_H_
+#define GS_HITFLAGS_H_
+
+#include "GS_ChannelMap.h"
+#include <TH2.h>
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TString.h>
+#include <cstdio>
+
+enum HitFlagBit {
+	kFlagPileup = 0,
+	kFlagPeak,
+	kFlagOffset,
+	kFlagSync,
+	kFlagError,
+	kNumHitFlags
+};
+
+const char *const kHitFlagNames[kNumHitFlags] = { "pileup", "peak", "offset", "sync", "error" };
+
+// Bit mask for a '+'-separated list of flag names, 0 for an empty list
+inline UInt_t HitFlagMask( const TString &list ){
+	if ( list == "all" ){ return ( 1 << kNumHitFlags ) - 1; }
+	UInt_t mask = 0;
+	TObjArray *names = list.Tokenize("+");
+	for ( Int_t i = 0; i < names->GetEntries(); i++ ){
+		TString name = ((TObjString*)names->At(i))->GetString();
+		Int_t bit = 0;
+		while ( bit < kNumHitFlags && name != kHitFlagNames[bit] ){ bit++; }
+		if ( bit < kNumHitFlags ){ mask |= ( 1 << bit ); }
+		else{ printf("Unknown hit flag \"%s\" (pileup, peak, offset, sync, error or all)\n", name.Data() ); }
+	}
+	delete names;
+	return mask;
+}
+
+// Flag masks of n hits, one pass over the raw tree arrays (no branches, so it vectorises)
+inline void HitFlags( Int_t n, const UShort_t *pileup, const UShort_t *peakValid, const UShort_t *offset,
+	const UShort_t *sync, const UShort_t *error, UChar_t *flags ){
+	for ( Int_t i = 0; i < n; i++ ){
+		flags[i] = ( ( pileup[i] != 0 ) << kFlagPileup ) | ( ( peakValid[i] == 0 ) << kFlagPeak ) |
+			( ( offset[i] != 0 ) << kFlagOffset ) | ( ( sync[i] != 0 ) << kFlagSync ) |
+			( ( error[i] != 0 ) << kFlagError );
+	}
+}
+
+// Hits, flags and rejected hits per raw channel id
+class HitFlagMonitor {
+public:
+	HitFlagMonitor(){ Clear(); }
+
+	void Clear(){
+		for ( Int_t i = 0; i < kMaxChannelId; i++ ){
+			for ( Int_t j = 0; j < kNumRows; j++ ){ fCounts[i][j] = 0; }
+		}
+	}
+
+	void Fill( Int_t id, UChar_t flags, Bool_t rejected ){
+		if ( id < 0 || id >= kMaxChannelId ){ return; }
+		fCounts[id][0]++;
+		for ( Int_t j = 0; j < kNumHitFlags; j++ ){ fCounts[id][j+1] += ( ( flags >> j ) & 1 ); }
+		fCounts[id][kNumRows-1] += rejected;
+	}
+
+	// Write hFlags (raw id against hits, each flag and rejected) into the current directory
+	void Write() const {
+		TH2D h( "hFlags", "Hit flags per channel;Raw channel id;", kMaxChannelId, 0, kMaxChannelId,
+			kNumRows, 0, kNumRows );
+		h.GetYaxis()->SetBinLabel( 1, "hits" );
+		for ( Int_t j = 0; j < kNumHitFlags; j++ ){ h.GetYaxis()->SetBinLabel( j + 2, kHitFlagNames[j] ); }
+		h.GetYaxis()->SetBinLabel( kNumRows, "rejected" );
+		for ( Int_t i = 0; i < kMaxChannelId; i++ ){
+			if ( fCounts[i][0] == 0 ){ continue; }
+			for ( Int_t j = 0; j < kNumRows; j++ ){ h.SetBinContent( i + 1, j + 1, fCounts[i][j] ); }
+		}
+		h.Write( "", TObject::kOverwrite );
+	}
+
+	// Table of the flag rates (in %) of every channel with at least one flagged hit
+	void Print() const {
+		Bool_t header = kFALSE;
+		for ( Int_t i = 0; i < kMaxChannelId; i++ ){
+			Long64_t flagged = 0;
+			for ( Int_t j = 1; j < kNumRows; j++ ){ flagged += fCounts[i][j]; }
+			if ( flagged == 0 ){ continue; }
+			if ( !header ){
+				printf("Hit flags per channel (%% of hits):\n%6s %12s", "id", "hits" );
+				for ( Int_t j = 0; j < kNumHitFlags; j++ ){ printf(" %8s", kHitFlagNames[j] ); }
+				printf(" %8s\n", "rejected" );
+				header = kTRUE;
+			}
+			printf("%6d %12lld", i, fCounts[i][0] );
+			for ( Int_t j = 1; j < kNumRows; j++ ){ printf(" %8.3f", 100.0*fCounts[i][j]/fCounts[i][0] ); }
+			printf("\n");
+		}
+		if ( !header ){ printf("No flagged hits\n"); }
+	}
+
+private:
+	static const Int_t kNumRows = kNumHitFlags + 2;		// hits, the flags, rejected
+
+	Long64_t fCounts[kMaxChannelId][kNumRows];
+};
+
+#endif
@@ -0,0 +1,75 @@
+// GS_HitList.h
+// Sparse gen_tree layout written by GeneralSort with the "format=hits" option. Instead of the
+// NaN-padded e[100], xf[100], ... arrays (and their timestamps) every event only stores the
+// channels that fired, as a variable-length list of (kind, detector, energy, timestamp):
+//   nhit/I, hit_kind[nhit]/b, hit_det[nhit]/b, hit_e[nhit]/F, hit_t[nhit]/l
+// plus hit_ft[nhit]/F, the CFD fine time (GS_CFDTiming.h), when the raw tree has CFD words,
+// and hit_flag[nhit]/b, the tagged flags of the hit (GS_HitFlags.h), with the tag= option.
+// The EBIS branch is written as before. ClearHitSlots and FillHitSlots let readers (PTMonitors)
+// rebuild the fixed-size arrays of the original layout from a hit list.
+// ============================================================================================= //
+#ifndef GS_HITLIST_H_
+#define GS_HITLIST_H_
+
+#include <TMath.h>
+#include <TTree.h>
+
+// Detector kinds, in the order of the fixed-size arrays in the original gen_tree
+enum HitKind {
+	kHitE = 0,		// e     - array energy
+	kHitXF,			// xf    - array far end
+	kHitXN,			// xn    - array near end
+	kHitRDT,		// rdt   - recoil detectors
+	kHitTAC,		// tac   - TAC & RF timing
+	kHitELUM,		// elum  - luminosity detectors
+	kHitEZERO,		// ezero - zero-degree detectors
+	kNumHitKinds
+};
+
+// Number of slots of each kind in the original gen_tree layout
+const Int_t kHitKindSize[kNumHitKinds] = { 100, 100, 100, 100, 100, 32, 10 };
+
+// Branch and leaf names of each kind in the original gen_tree layout (e/Energy[100], e_t/EnergyTimestamp[100], ...)
+const char *const kHitKindBranch[kNumHitKinds] = { "e", "xf", "xn", "rdt", "tac", "elum", "ezero" };
+const char *const kHitKindLeaf[kNumHitKinds] = { "Energy", "XF", "XN", "RDT", "TAC", "ELUM", "EZERO" };
+
+const Int_t kMaxHits = 200;	// Same as the highest multiplicity in the raw tree
+
+typedef struct {
+	Int_t     NHits;
+	UChar_t   Kind[kMaxHits];
+	UChar_t   Det[kMaxHits];
+	Float_t   Energy[kMaxHits];
+	ULong64_t Timestamp[kMaxHits];
+	Float_t   Fine[kMaxHits];		// CFD fine time in ticks, NaN if none
+	UChar_t   Flag[kMaxHits];		// Tagged flags (GS_HitFlags.h), 0 if none
+} HitList;
+
+// Returns kTRUE if the tree was written in the hit-list layout
+inline Bool_t IsHitListTree( TTree *t ){
+	return ( t != NULL && t->GetBranch("nhit") != NULL );
+}
+
+// Reset the array slots that the hits in the list were written to. Call this with the previous
+// event still in the list, so only the slots that were filled need to go back to NaN. fine, if
+// given, holds the fine-time array of each kind (NULL for kinds without one).
+inline void ClearHitSlots( const HitList &hits, Float_t **energy, ULong64_t **timestamp, Float_t **fine = NULL ){
+	for ( Int_t i = 0; i < hits.NHits; i++ ){
+		if ( hits.Kind[i] >= kNumHitKinds || hits.Det[i] >= kHitKindSize[ hits.Kind[i] ] ){ continue; }
+		energy[ hits.Kind[i] ][ hits.Det[i] ] = TMath::QuietNaN();
+		timestamp[ hits.Kind[i] ][ hits.Det[i] ] = TMath::QuietNaN();
+		if ( fine && fine[ hits.Kind[i] ] ){ fine[ hits.Kind[i] ][ hits.Det[i] ] = TMath::QuietNaN(); }
+	}
+}
+
+// Write the hits into the array slots. Later hits in the same slot win, as in the array layout.
+inline void FillHitSlots( const HitList &hits, Float_t **energy, ULong64_t **timestamp, Float_t **fine = NULL ){
+	for ( Int_t i = 0; i < hits.NHits; i++ ){
+		if ( hits.Kind[i] >= kNumHitKinds || hits.Det[i] >= kHitKindSize[ hits.Kind[i] ] ){ continue; }
+		energy[ hits.Kind[i] ][ hits.Det[i] ] = hits.Energy[i];
+		timestamp[ hits.Kind[i] ][ hits.Det[i] ] = hits.Timestamp[i];
+		if ( fine && fine[ hits.Kind[i] ] ){ fine[ hits.Kind[i] ][ hits.Det[i] ] = hits.Fine[i]; }
+	}
+}
+
+#endif
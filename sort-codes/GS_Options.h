@@ -0,0 +1,41 @@
+// GS_Options.h
+// Helpers for the option string handed to the sort selectors through TTree::Process, e.g.
+//   t->Process( "GeneralSort.C+", "out=gen_slice0.root entries=1000000 quiet" );
+// Options are whitespace- or comma-separated, and are either bare flags or key=value pairs.
+// ============================================================================================= //
+#ifndef GS_OPTIONS_H_
+#define GS_OPTIONS_H_
+
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TString.h>
+
+// Returns the value given to "key=" in the option string, or def if the key is absent
+inline TString GetOptionValue( const TString &option, const TString &key, const TString &def = "" ){
+	TString value = def;
+	TObjArray *tokens = option.Tokenize(" ,");
+	for ( Int_t i = 0; i < tokens->GetEntries(); i++ ){
+		TString tok = ((TObjString*)tokens->At(i))->GetString();
+		if ( tok.BeginsWith( key + "=" ) ){
+			value = tok( key.Length() + 1, tok.Length() );
+		}
+	}
+	delete tokens;
+	return value;
+}
+
+// Returns kTRUE if the bare flag (or a key=value pair with that key) is in the option string
+inline Bool_t HasOption( const TString &option, const TString &key ){
+	Bool_t found = kFALSE;
+	TObjArray *tokens = option.Tokenize(" ,");
+	for ( Int_t i = 0; i < tokens->GetEntries(); i++ ){
+		TString tok = ((TObjString*)tokens->At(i))->GetString();
+		if ( tok == key || tok.BeginsWith( key + "=" ) ){
+			found = kTRUE;
+		}
+	}
+	delete tokens;
+	return found;
+}
+
+#endif
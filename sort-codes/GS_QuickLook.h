@@ -0,0 +1,142 @@
+// GS_QuickLook.h
+// Quick-look selection of entries for GeneralSort, PTMonitors and AnalyseTree, so that a sort can
+// be cut down from the option string rather than by editing NUMSORT:
+//   prescale=N      keep every Nth entry
+//   sample=f        keep a fraction f (0 < f <= 1) of the entries, spread evenly over the file
+//   tmin=a tmax=b   keep only events a <= t < b seconds after the first event of the file
+//   tref=T          count tmin/tmax from timestamp T instead, e.g. the run start from the
+//                   ts_index when only part of the file is read (GS_TimeIndex.h)
+//   max=N           stop after N entries have been kept (NUMSORT by default)
+// prescale and sample are decided from the entry number alone, so the entry does not have to be
+// read to be skipped, and the spectra are of the whole run at lower statistics. The factor that
+// takes those counts back to the full run (Scale()) is multiplied down the chain: each stage
+// reads the QuickLookScale parameter of its input file (ReadScale), writes the product into its
+// output (WriteScale) and scales its histograms by it (ScaleHist). A time window is a selection
+// rather than a sample and does not change the scale.
+// ============================================================================================= //
+#ifndef GS_QUICKLOOK_H_
+#define GS_QUICKLOOK_H_
+
+#include "GS_Options.h"
+#include <TChain.h>
+#include <TFile.h>
+#include <TH1.h>
+#include <TMath.h>
+#include <TParameter.h>
+#include <TString.h>
+#include <TTree.h>
+
+class QuickLook {
+public:
+	ULong64_t Prescale;		// Keep every Prescale'th entry, 1 = all
+	Double_t  Sample;		// Fraction of entries kept, 1 = all
+	Double_t  TMin;			// Time window in seconds from the first event, TMax <= 0 = no upper limit
+	Double_t  TMax;
+	ULong64_t Max;			// Most entries to keep
+	Double_t  Upstream;		// Scale of the input file, from the stage before
+	Double_t  Tick;			// Length of one timestamp count in seconds
+
+	QuickLook() : Prescale(1), Sample(1), TMin(0), TMax(0), Max(0), Upstream(1), Tick(1e-8),
+		fFirstTimestamp(0), fHaveTimestamp(kFALSE) {}
+
+	// Read the options above, with defMax entries kept when max= is not given
+	void Configure( const TString &option, ULong64_t defMax ){
+		Prescale = GetOptionValue( option, "prescale", "1" ).Atoll();
+		Sample = GetOptionValue( option, "sample", "1" ).Atof();
+		TMin = GetOptionValue( option, "tmin", "0" ).Atof();
+		TMax = GetOptionValue( option, "tmax", "0" ).Atof();
+		Max = ( HasOption( option, "max" ) ? GetOptionValue( option, "max" ).Atoll() : defMax );
+		if ( Prescale < 1 ){ Prescale = 1; }
+		if ( Sample <= 0 || Sample > 1 ){ Sample = 1; }
+		if ( HasOption( option, "tref" ) ){
+			fFirstTimestamp = GetOptionValue( option, "tref" ).Atoll();
+			fHaveTimestamp = kTRUE;
+		}
+	}
+
+	void Print() const {
+		if ( !IsActive() ){ return; }
+		printf("Quick look: prescale %llu, sample %g, time %g-%g s, at most %llu entries (scale %g)\n",
+			Prescale, Sample, TMin, TMax, Max, Scale() );
+	}
+
+	Bool_t IsActive() const { return ( Prescale > 1 || Sample < 1 || HasTimeWindow() ); }
+	Bool_t HasTimeWindow() const { return ( TMin > 0 || TMax > 0 ); }
+
+	// Prescale and sample test, before the entry is read
+	Bool_t KeepEntry( Long64_t entry ) const {
+		if ( Prescale > 1 && entry % Prescale != 0 ){ return kFALSE; }
+		if ( Sample < 1 && (Long64_t)( ( entry + 1 )*Sample ) == (Long64_t)( entry*Sample ) ){ return kFALSE; }
+		return kTRUE;
+	}
+
+	// Time window test on the timestamp of an event that passed KeepEntry. An event without one
+	// (0) cannot be placed in the window and is dropped when there is a window.
+	Bool_t KeepTime( ULong64_t timestamp ){
+		if ( !HasTimeWindow() ){ return kTRUE; }
+		if ( timestamp == 0 ){ return kFALSE; }
+		if ( !fHaveTimestamp ){
+			fFirstTimestamp = timestamp;
+			fHaveTimestamp = kTRUE;
+		}
+		Double_t t = ( (Double_t)timestamp - (Double_t)fFirstTimestamp )*Tick;
+		return ( t >= TMin && ( TMax <= 0 || t < TMax ) );
+	}
+
+	Bool_t Keep( Long64_t entry, ULong64_t timestamp ){ return ( KeepEntry( entry ) && KeepTime( timestamp ) ); }
+
+	// Entries expected to be kept out of numEntries (before any time window), for progress reports
+	ULong64_t Expected( ULong64_t numEntries ) const {
+		return (ULong64_t)TMath::Ceil( numEntries*Sample/Prescale );
+	}
+
+	// Factor from the kept counts to those of the full run
+	Double_t Scale() const { return Upstream*Prescale/Sample; }
+
+	// Pick up the scale of a quick-look input (1 for a full sort)
+	void ReadScale( TTree *tree ){
+		TFile *f = ( tree ? tree->GetCurrentFile() : NULL );
+		if ( f == NULL && tree && tree->InheritsFrom("TChain") ){ f = ((TChain*)tree)->GetFile(); }
+		TParameter<Double_t> *p = ( f ? (TParameter<Double_t>*)f->Get("QuickLookScale") : NULL );
+		Upstream = ( p ? p->GetVal() : 1 );
+		if ( Upstream != 1 ){ printf("Input is a quick look, scale %g\n", Upstream ); }
+	}
+
+	// Write the scale into the current directory if it is not 1. Merged slices keep one copy.
+	void WriteScale() const {
+		if ( Scale() == 1 ){ return; }
+		TParameter<Double_t> p( "QuickLookScale", Scale() );
+		p.SetBit( TParameter<Double_t>::kIsConst );
+		p.Write( "", TObject::kOverwrite );
+	}
+
+	// Scale a histogram to full-run counts, with errors from the counts actually seen
+	void ScaleHist( TH1 *h ) const {
+		if ( h == NULL || Scale() == 1 ){ return; }
+		if ( h->GetSumw2N() == 0 ){ h->Sumw2(); }
+		h->Scale( Scale() );
+	}
+
+private:
+	ULong64_t fFirstTimestamp;
+	Bool_t    fHaveTimestamp;
+};
+
+// Earliest valid timestamp of n array slots (unfilled slots hold a NaN cast to ULong64_t), or 0
+inline ULong64_t FirstTimestamp( const ULong64_t *t, Int_t n ){
+	const ULong64_t kMaxValid = 1ULL << 48;		// Digitizer timestamps are 48 bits
+	ULong64_t first = 0;
+	for ( Int_t i = 0; i < n; i++ ){
+		if ( t[i] > 0 && t[i] < kMaxValid && ( first == 0 || t[i] < first ) ){ first = t[i]; }
+	}
+	return first;
+}
+
+// Time of a sorted event (gen_tree or fin_tree): its earliest array or recoil hit, or 0. The
+// tmin=/tmax= window and ts_index of fin_tree both use it.
+inline ULong64_t EventTimestamp( const ULong64_t *e_t, const ULong64_t *rdt_t, Int_t n = 100 ){
+	ULong64_t t = FirstTimestamp( e_t, n ), t_rdt = FirstTimestamp( rdt_t, n );
+	return ( t == 0 || ( t_rdt > 0 && t_rdt < t ) ? t_rdt : t );
+}
+
+#endif
@@ -0,0 +1,157 @@
+// GS_RateMonitor.h
+// Fixed-memory event-rate monitor for the sorts, in place of an hEvents histogram with one bin
+// per entry. Events are counted per second of wall-clock time (sort throughput) and per second
+// of digitizer timestamp (beam/trigger rate). Each is held in a fixed number of bins: when an
+// event falls beyond the last bin, neighbouring bins are merged in pairs and the bin width is
+// doubled, so memory stays the same for any length of run and the whole run is always covered.
+// Write() stores both as histograms of events/s in the current directory.
+// Slices sorted apart and merged afterwards (GeneralSortMT.C) must agree on the beam histogram:
+// Configure() takes its origin from tref= and, with ratespan= (seconds of timestamp to cover),
+// fixes its binning to what the whole run would end with, so every slice writes the same axis.
+// ============================================================================================= //
+#ifndef GS_RATEMONITOR_H_
+#define GS_RATEMONITOR_H_
+
+#include "GS_Options.h"
+#include <TH1.h>
+#include <TMath.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <vector>
+
+// Counts in numBins bins of width Width (seconds) starting at 0, doubling the width as needed
+class RateBuffer {
+public:
+	Double_t Width;
+	Double_t Underflow;		// Counts before time 0
+	Double_t Overflow;		// Counts beyond maxTime
+
+	RateBuffer( Int_t numBins = 4096, Double_t width = 1.0, Double_t maxTime = 1e7 ) : Width(width),
+		Underflow(0), Overflow(0), fBins( numBins, 0 ), fLast(-1), fMaxTime(maxTime), fFixed(kFALSE) {}
+
+	// Bin as the buffer would after a run of span seconds, and keep that binning: the width is
+	// doubled up front until span fits, and later counts beyond the last bin go to Overflow.
+	// MakeHist then always writes every bin.
+	void Fix( Double_t span ){
+		while ( span >= Width*fBins.size() ){ Rebin(); }
+		fMaxTime = Width*fBins.size();
+		fFixed = kTRUE;
+	}
+
+	void Add( Double_t t, Double_t n = 1 ){
+		if ( t < 0 ){
+			Underflow += n;
+			return;
+		}
+		if ( t >= fMaxTime ){
+			Overflow += n;		// e.g. a corrupt timestamp, which would otherwise squash everything
+			return;
+		}
+		while ( t >= Width*fBins.size() ){ Rebin(); }
+		Int_t bin = (Int_t)( t/Width );
+		fBins[bin] += n;
+		if ( bin > fLast ){ fLast = bin; }
+	}
+
+	Double_t Integral() const {
+		Double_t sum = 0;
+		for ( Int_t i = 0; i <= fLast; i++ ){ sum += fBins[i]; }
+		return sum;
+	}
+
+	// Rate (counts per second) over the filled range
+	TH1D *MakeHist( const char *name, const char *title ) const {
+		Int_t n = ( fFixed ? (Int_t)fBins.size() : ( fLast >= 0 ? fLast + 1 : 1 ) );
+		TH1D *h = new TH1D( name, title, n, 0, n*Width );
+		for ( Int_t i = 0; i < n; i++ ){
+			h->SetBinContent( i + 1, fBins[i]/Width );
+			h->SetBinError( i + 1, TMath::Sqrt( fBins[i] )/Width );
+		}
+		h->SetEntries( Integral() );
+		return h;
+	}
+
+private:
+	std::vector<Double_t> fBins;
+	Int_t                 fLast;		// Last bin filled
+	Double_t              fMaxTime;
+	Bool_t                fFixed;		// Binning set by Fix()
+
+	void Rebin(){
+		Int_t n = fBins.size();
+		for ( Int_t i = 0; i < n/2; i++ ){ fBins[i] = fBins[2*i] + fBins[2*i+1]; }
+		for ( Int_t i = n/2; i < n; i++ ){ fBins[i] = 0; }
+		fLast /= 2;
+		Width *= 2;
+	}
+};
+
+class RateMonitor {
+public:
+	RateBuffer Wall;		// Events per second of sorting
+	RateBuffer Beam;		// Events per second of digitizer time
+
+	// tick is the length of one timestamp count in seconds (10 ns for the digitizers)
+	RateMonitor( Int_t numBins = 4096, Double_t tick = 1e-8 ) : Wall( numBins ), Beam( numBins ),
+		fTick(tick), fFirstTimestamp(0), fHaveTimestamp(kFALSE), fStart(0), fPending(0) {}
+
+	// tref= as the origin of the beam rate (otherwise the first timestamp seen), and ratespan= to
+	// fix its binning, as given to every slice by GeneralSortMT.C
+	void Configure( const TString &option ){
+		if ( HasOption( option, "tref" ) ){
+			fFirstTimestamp = GetOptionValue( option, "tref" ).Atoll();
+			fHaveTimestamp = kTRUE;
+		}
+		if ( HasOption( option, "ratespan" ) ){ Beam.Fix( GetOptionValue( option, "ratespan" ).Atof() ); }
+	}
+
+	// Start the wall clock (otherwise it starts at the first clock reading)
+	void Start(){ fStart = gSystem->Now(); }
+
+	// Count one event. Timestamps are taken relative to the first one seen.
+	void Fill( ULong64_t timestamp ){
+		if ( !fHaveTimestamp ){
+			fFirstTimestamp = timestamp;
+			fHaveTimestamp = kTRUE;
+		}
+		Beam.Add( ( (Double_t)timestamp - (Double_t)fFirstTimestamp )*fTick );
+
+		// Only read the clock every kClockEvery events
+		if ( ++fPending >= kClockEvery ){ Flush(); }
+	}
+
+	// Count one event that has no usable timestamp
+	void Fill(){
+		if ( ++fPending >= kClockEvery ){ Flush(); }
+	}
+
+	// Put the events counted since the last clock reading in the current wall-clock second
+	void Flush(){
+		Long64_t now = gSystem->Now();
+		if ( fStart == 0 ){ fStart = now; }
+		Wall.Add( ( now - fStart )/1000.0, fPending );
+		fPending = 0;
+	}
+
+	// Write the rates into the current directory
+	void Write( const char *prefix = "hRate" ){
+		Flush();
+		TH1D *h = Wall.MakeHist( Form( "%sWall", prefix ), "Sort rate;Time since start of sort (s);Events/s" );
+		h->Write();
+		delete h;
+		h = Beam.MakeHist( Form( "%sBeam", prefix ), "Event rate;Timestamp since first event (s);Events/s" );
+		h->Write();
+		delete h;
+	}
+
+private:
+	static const Int_t kClockEvery = 4096;
+
+	Double_t  fTick;
+	ULong64_t fFirstTimestamp;
+	Bool_t    fHaveTimestamp;
+	Long64_t  fStart;		// gSystem->Now() at the first reading, in ms
+	Double_t  fPending;		// Events not yet put in the wall-clock buffer
+};
+
+#endif
@@ -0,0 +1,192 @@
+// GS_RecoilGate.h
+// The recoil gate of an event: TCutG k on the E-dE plane of recoil telescope k, tested on
+// (rdt[k+4], rdt[k]) as PTMonitors and AnalyseTree do. RecoilGate::Evaluate tests the cuts once
+// per event, and the array loops then use In[k] (or the Mask) instead of calling IsInside for
+// every detector.
+// Each cut can also be rasterised (RasterCut), a bitmap at the binning of the EdE plots that holds
+// for every bin whether it is inside, outside, or on the edge of the polygon. A point then costs
+// one look-up, and only points in edge bins (those a side of the polygon passes through, with a
+// bin of margin) and points outside the bitmap go to the exact TCutG::IsInside, so the result is
+// the same as the exact test. It is optional ("rastercut" in PTMonitors and AnalyseTree), as the
+// bitmaps take a moment and a few MB to make at start-up.
+// ============================================================================================= //
+#ifndef GS_RECOILGATE_H_
+#define GS_RECOILGATE_H_
+
+#include <TCutG.h>
+#include <TH1.h>
+#include <TMath.h>
+#include <TObjArray.h>
+#include <TString.h>
+#include <cstdio>
+#include <vector>
+
+const Int_t kMaxRecoilCuts = 4;		// One per recoil telescope
+
+// TCutG on a bitmap, with the exact test near the edges
+class RasterCut {
+public:
+	Long64_t NumLookup;		// Points decided by the bitmap
+	Long64_t NumExact;		// Points left to TCutG::IsInside
+
+	RasterCut() : NumLookup(0), NumExact(0), fCut(0), fNx(0), fNy(0) {}
+
+	// Bitmap of cut on the bins of (nx, xmin, xmax) x (ny, ymin, ymax), over the bins covering
+	// the cut only. Without points it is left empty and every test is exact.
+	void Set( TCutG *cut, Int_t nx, Double_t xmin, Double_t xmax, Int_t ny, Double_t ymin, Double_t ymax ){
+		fCut = cut;
+		fNx = fNy = 0;
+		fCell.clear();
+		Int_t n = cut->GetN();
+		if ( n < 3 ){ return; }
+		const Double_t *px = cut->GetX(), *py = cut->GetY();
+
+		// Bounding box of the polygon, outside which everything is outside
+		fBoxX[0] = fBoxX[1] = px[0];
+		fBoxY[0] = fBoxY[1] = py[0];
+		for ( Int_t i = 1; i < n; i++ ){
+			fBoxX[0] = TMath::Min( fBoxX[0], px[i] ); fBoxX[1] = TMath::Max( fBoxX[1], px[i] );
+			fBoxY[0] = TMath::Min( fBoxY[0], py[i] ); fBoxY[1] = TMath::Max( fBoxY[1], py[i] );
+		}
+
+		// Bins of the box, clipped to the range given
+		fW = ( xmax - xmin )/nx; fH = ( ymax - ymin )/ny;
+		Int_t ix0 = TMath::Max( 0, (Int_t)TMath::Floor( ( fBoxX[0] - xmin )/fW ) );
+		Int_t ix1 = TMath::Min( nx - 1, (Int_t)TMath::Floor( ( fBoxX[1] - xmin )/fW ) );
+		Int_t iy0 = TMath::Max( 0, (Int_t)TMath::Floor( ( fBoxY[0] - ymin )/fH ) );
+		Int_t iy1 = TMath::Min( ny - 1, (Int_t)TMath::Floor( ( fBoxY[1] - ymin )/fH ) );
+		if ( ix1 < ix0 || iy1 < iy0 ){ return; }
+		fNx = ix1 - ix0 + 1; fNy = iy1 - iy0 + 1;
+		fX0 = xmin + ix0*fW; fY0 = ymin + iy0*fH;
+		fCell.assign( fNx*fNy, kUnknown );
+
+		// Edge bins: every bin a side passes through, sampled at half a bin, and its neighbours
+		for ( Int_t i = 0; i < n; i++ ){
+			Double_t x0 = px[i], y0 = py[i], x1 = px[(i+1)%n], y1 = py[(i+1)%n];
+			Int_t steps = 1 + (Int_t)( 2*TMath::Max( TMath::Abs( x1 - x0 )/fW, TMath::Abs( y1 - y0 )/fH ) );
+			for ( Int_t s = 0; s <= steps; s++ ){
+				Double_t f = (Double_t)s/steps;
+				Int_t ix = (Int_t)TMath::Floor( ( x0 + f*( x1 - x0 ) - fX0 )/fW );
+				Int_t iy = (Int_t)TMath::Floor( ( y0 + f*( y1 - y0 ) - fY0 )/fH );
+				for ( Int_t jx = ix - 1; jx <= ix + 1; jx++ ){
+					for ( Int_t jy = iy - 1; jy <= iy + 1; jy++ ){
+						if ( jx >= 0 && jx < fNx && jy >= 0 && jy < fNy ){ fCell[ jy*fNx + jx ] = kEdge; }
+					}
+				}
+			}
+		}
+
+		// No side passes through the other bins, so their centre decides them
+		Long64_t numEdge = 0;
+		for ( Int_t jy = 0; jy < fNy; jy++ ){
+			for ( Int_t jx = 0; jx < fNx; jx++ ){
+				UChar_t &c = fCell[ jy*fNx + jx ];
+				if ( c == kEdge ){ numEdge++; continue; }
+				c = ( cut->IsInside( fX0 + ( jx + 0.5 )*fW, fY0 + ( jy + 0.5 )*fH ) ? kIn : kOut );
+			}
+		}
+		printf("Rasterised cut %s: %d x %d bins, %.1f%% on the edge\n", cut->GetName(), fNx, fNy,
+			100.0*numEdge/( fNx*fNy ) );
+	}
+
+	// At the binning of a histogram of the plane, e.g. an EdE plot
+	void Set( TCutG *cut, const TH1 *binning ){
+		const TAxis *ax = binning->GetXaxis(), *ay = binning->GetYaxis();
+		Set( cut, ax->GetNbins(), ax->GetXmin(), ax->GetXmax(), ay->GetNbins(), ay->GetXmin(), ay->GetXmax() );
+	}
+
+	Bool_t IsInside( Double_t x, Double_t y ){
+		if ( fNx == 0 ){
+			NumExact++;
+			return fCut->IsInside( x, y );
+		}
+		// Outside the box (or NaN)
+		if ( !( x >= fBoxX[0] && x <= fBoxX[1] && y >= fBoxY[0] && y <= fBoxY[1] ) ){
+			NumLookup++;
+			return kFALSE;
+		}
+		Int_t ix = (Int_t)TMath::Floor( ( x - fX0 )/fW ), iy = (Int_t)TMath::Floor( ( y - fY0 )/fH );
+		if ( ix >= 0 && ix < fNx && iy >= 0 && iy < fNy ){
+			UChar_t c = fCell[ iy*fNx + ix ];
+			if ( c != kEdge ){
+				NumLookup++;
+				return ( c == kIn );
+			}
+		}
+		NumExact++;
+		return fCut->IsInside( x, y );
+	}
+
+private:
+	enum { kUnknown, kOut, kIn, kEdge };
+	TCutG   *fCut;
+	Int_t    fNx, fNy;				// Bins of the bitmap
+	Double_t fX0, fY0, fW, fH;		// Low edge of its first bin, and the bin size
+	Double_t fBoxX[2], fBoxY[2];	// Bounding box of the polygon
+	std::vector<UChar_t> fCell;
+};
+
+// The cuts of the recoil telescopes, tested once per event
+class RecoilGate {
+public:
+	Int_t  N;						// Cuts set, cut k on telescope k
+	Bool_t In[kMaxRecoilCuts];		// Event inside cut k, after Evaluate
+	Int_t  Mask;					// Bit k set for In[k]
+	TString Name;					// Where the cuts came from, e.g. the cut file, for PrintUsage
+
+	RecoilGate() : N(0), Mask(0), fRaster(kFALSE) {
+		for ( Int_t k = 0; k < kMaxRecoilCuts; k++ ){ fCut[k] = 0; In[k] = kFALSE; }
+	}
+
+	// Cuts 0..n-1 of a cut list, read from name
+	void Set( const TObjArray *cutList, const char *name ){
+		Name = name;
+		N = TMath::Min( cutList->GetEntries(), kMaxRecoilCuts );
+		if ( cutList->GetEntries() > kMaxRecoilCuts ){
+			printf("Only the first %d recoil cuts are used\n", kMaxRecoilCuts );
+		}
+		for ( Int_t k = 0; k < N; k++ ){ fCut[k] = (TCutG*)cutList->At(k); }
+		fRaster = kFALSE;
+	}
+
+	TCutG *Cut( Int_t k ) const { return fCut[k]; }
+
+	// Use bitmaps of the cuts on (nx, xmin, xmax) x (ny, ymin, ymax), the EdE plots of PTMonitors
+	// by default, or on the binning of a histogram
+	void Rasterise( Int_t nx = 1000, Double_t xmin = 0, Double_t xmax = 10000, Int_t ny = 1000,
+		Double_t ymin = 0, Double_t ymax = 4000 ){
+		for ( Int_t k = 0; k < N; k++ ){ fRasterCut[k].Set( fCut[k], nx, xmin, xmax, ny, ymin, ymax ); }
+		fRaster = kTRUE;
+	}
+	void Rasterise( const TH1 *binning ){
+		for ( Int_t k = 0; k < N; k++ ){ fRasterCut[k].Set( fCut[k], binning ); }
+		fRaster = kTRUE;
+	}
+
+	// Test the event, rdt being the recoil array of the tree (dE in 0-3, E in 4-7)
+	Int_t Evaluate( const Float_t *rdt ){
+		Mask = 0;
+		for ( Int_t k = 0; k < N; k++ ){
+			In[k] = ( fRaster ? fRasterCut[k].IsInside( rdt[k+4], rdt[k] ) : fCut[k]->IsInside( rdt[k+4], rdt[k] ) );
+			Mask |= ( In[k] << k );
+		}
+		return Mask;
+	}
+
+	void PrintUsage() const {
+		if ( !fRaster ){ return; }
+		Long64_t lookup = 0, exact = 0;
+		for ( Int_t k = 0; k < N; k++ ){
+			lookup += fRasterCut[k].NumLookup;
+			exact += fRasterCut[k].NumExact;
+		}
+		printf("Recoil cuts %s: %lld tests from the bitmaps, %lld exact\n", Name.Data(), lookup, exact );
+	}
+
+private:
+	TCutG    *fCut[kMaxRecoilCuts];
+	RasterCut fRasterCut[kMaxRecoilCuts];
+	Bool_t    fRaster;
+};
+
+#endif
@@ -0,0 +1,147 @@
+// GS_TimeIndex.h
+// Sparse timestamp index of a sorted tree, so that a time window of a run can be read without a
+// scan of the whole tree. GeneralSort (gen_tree) and PTMonitors (fin_tree) write it next to their
+// tree as ts_index, one entry per block of "tsindex=" entries (1000 by default, 0 for none):
+//   entry/L   first entry of the block in the indexed tree
+//   n/I       entries in the block
+//   tmin/l    earliest and latest event timestamps in the block (events without one are left out)
+//   tmax/l
+// The title of ts_index names the tree it indexes. TimeWindowEntries() turns a window in seconds
+// from the start of the run into the entry range covering it, to hand to TTree::Process/Draw so
+// that only those baskets are read. The range is made of whole blocks, so the exact cut is still
+// to be made on the events, e.g. with the tmin=/tmax= quick-look options and tref= set to the run
+// start (TimeIndexStart()) so that they count from the same point:
+//   Long64_t first, n;
+//   if ( TimeWindowEntries( t, 2400, 2700, first, n ) ) t->Process( "AnalyseTree.C+",
+//      Form( "tmin=2400 tmax=2700 tref=%llu", TimeIndexStart( t ) ), n, first );
+// Slices merged by GeneralSortMT each count their entries from 0; the reader adds up the slices
+// in the order they were merged.
+// ============================================================================================= //
+#ifndef GS_TIMEINDEX_H_
+#define GS_TIMEINDEX_H_
+
+#include "GS_Options.h"
+#include <TFile.h>
+#include <TString.h>
+#include <TTree.h>
+#include <cstdio>
+
+class TimeIndexBuilder {
+public:
+	Long64_t BlockSize;		// Entries per index point, "tsindex="
+	TTree   *Tree;
+
+	TimeIndexBuilder() : BlockSize(1000), Tree(0), fEntry(0), fN(0), fTMin(0), fTMax(0) {}
+
+	void Configure( const TString &option ){
+		BlockSize = GetOptionValue( option, "tsindex", "1000" ).Atoll();
+	}
+
+	// Book ts_index in the current directory, for the tree called treeName
+	void Book( const char *treeName ){
+		if ( BlockSize <= 0 ){ return; }
+		Tree = new TTree( "ts_index", Form( "Timestamp index of %s", treeName ) );
+		Tree->Branch( "entry", &fEntry, "entry/L" );
+		Tree->Branch( "n", &fN, "n/I" );
+		Tree->Branch( "tmin", &fTMin, "tmin/l" );
+		Tree->Branch( "tmax", &fTMax, "tmax/l" );
+	}
+
+	// Record the entry about to be filled into the indexed tree, with its event timestamp
+	// (0 if it has none)
+	void Fill( Long64_t entry, ULong64_t timestamp ){
+		if ( Tree == NULL ){ return; }
+		if ( fN == 0 ){
+			fEntry = entry;
+			fTMin = fTMax = 0;
+		}
+		if ( timestamp > 0 ){
+			if ( fTMin == 0 || timestamp < fTMin ){ fTMin = timestamp; }
+			if ( timestamp > fTMax ){ fTMax = timestamp; }
+		}
+		if ( ++fN == BlockSize ){ Flush(); }
+	}
+
+	// Write the last block and ts_index into its file
+	void Write(){
+		if ( Tree == NULL ){ return; }
+		Flush();
+		Tree->Write( "", TObject::kOverwrite );
+	}
+
+private:
+	Long64_t  fEntry;
+	Int_t     fN;
+	ULong64_t fTMin, fTMax;
+
+	void Flush(){
+		if ( fN == 0 ){ return; }
+		Tree->Fill();
+		fN = 0;
+	}
+};
+
+// ts_index in the file of a tree, or NULL
+inline TTree *GetTimeIndex( TTree *t ){
+	TFile *f = ( t ? t->GetCurrentFile() : NULL );
+	return ( f ? (TTree*)f->Get("ts_index") : NULL );
+}
+
+// Timestamp of the start of the run: the earliest timestamp of the first block, 0 without an index
+inline ULong64_t TimeIndexStart( TTree *t ){
+	TTree *index = GetTimeIndex( t );
+	if ( index == NULL || index->GetEntries() == 0 ){ return 0; }
+	ULong64_t tmin = 0;
+	index->SetBranchAddress( "tmin", &tmin );
+	index->GetEntry(0);
+	index->ResetBranchAddresses();
+	return tmin;
+}
+
+// Entries [first, first + n) of t that hold the events from tmin to tmax seconds after the start
+// of the run (tmax <= 0 for no upper limit). Returns kFALSE, with the whole tree as the range, if
+// there is no index to use.
+inline Bool_t TimeWindowEntries( TTree *t, Double_t tmin, Double_t tmax, Long64_t &first, Long64_t &n,
+	Double_t tick = 1e-8 ){
+	first = 0;
+	n = ( t ? t->GetEntries() : 0 );
+	TTree *index = GetTimeIndex( t );
+	if ( index == NULL || index->GetEntries() == 0 ){
+		printf("No ts_index for %s, reading all of it\n", ( t ? t->GetName() : "the tree" ) );
+		return kFALSE;
+	}
+
+	Long64_t entry, offset = 0, prevEnd = 0;
+	Int_t num;
+	ULong64_t bmin, bmax;
+	index->SetBranchAddress( "entry", &entry );
+	index->SetBranchAddress( "n", &num );
+	index->SetBranchAddress( "tmin", &bmin );
+	index->SetBranchAddress( "tmax", &bmax );
+
+	ULong64_t start = 0;
+	Long64_t lo = -1, hi = -1;
+	for ( Long64_t i = 0; i < index->GetEntries(); i++ ){
+		index->GetEntry(i);
+		if ( i == 0 ){ start = bmin; }
+		if ( entry + offset < prevEnd ){ offset = prevEnd; }	// Next GeneralSortMT slice
+		prevEnd = entry + offset + num;
+		if ( bmax == 0 ){ continue; }		// No timestamps in the block
+		Double_t s0 = ( (Double_t)bmin - (Double_t)start )*tick, s1 = ( (Double_t)bmax - (Double_t)start )*tick;
+		if ( s1 < tmin || ( tmax > 0 && s0 >= tmax ) ){ continue; }
+		if ( lo < 0 || entry + offset < lo ){ lo = entry + offset; }
+		if ( prevEnd > hi ){ hi = prevEnd; }
+	}
+	index->ResetBranchAddresses();
+
+	if ( lo < 0 ){
+		n = 0;
+		printf("No entries of %s from %g to %g s\n", t->GetName(), tmin, tmax );
+		return kTRUE;
+	}
+	first = lo;
+	n = hi - lo;
+	return kTRUE;
+}
+
+#endif
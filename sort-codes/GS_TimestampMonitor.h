@@ -0,0 +1,277 @@
+// GS_TimestampMonitor.h
+// Timestamp health of each digitizer, checked while the run is sorted rather than found later in
+// a broken TD_Recoil/TD_EBIS. The board of a hit is its raw id / 10. For every board it watches:
+//   backward   a hit more than kTSBackTolerance ticks before the previous hit of the board
+//              (a reset or a jump back of its clock)
+//   offset     in events with the EBIS reference (the EBIS channel of the map, id 1010), the
+//              median of hit - EBIS over blocks of kTSBlock hits. The first block is the learned
+//              offset of the board. A later block is off when its median is more than tsjump=
+//              ticks (50 by default) and more than kTSSignificance standard errors (from the
+//              median absolute deviations of the two blocks) away from it, as hit - EBIS spreads
+//              over the whole EBIS window and a block median alone moves by tens of ticks. It is
+//              a jump once kTSPersist blocks in a row are off the same way, and its size is the
+//              median of their medians
+//   lost       a board that was in EBIS events but then has hits and no EBIS event in a window of
+//              kTSLostWindow EBIS events, i.e. its clock moved out of the coincidence window
+// With "tsalign", the hits of a board that jumped are shifted back by the size of the jump, so
+// coincidences are restored for the rest of the run (from the block that confirmed it: the hits of
+// the blocks before are left as they were).
+// Under GeneralSortMT each slice learns its own offsets from its first block, so a jump before a
+// slice starts is not seen by it, and tsalign shifts the hits of a slice only by the jumps within
+// it: use the single-threaded sort to align a run with jumps. Write() stores the health record of the run:
+//   ts_health  one entry per board (hits, EBIS hits, incidents, learned and last offsets, shift)
+//   ts_jumps   one entry per incident (board, kind 0 backward/1 offset/2 lost, time in s, size)
+// and Print() lists the boards with incidents. Memory is fixed apart from the incident list,
+// which is capped at kTSMaxIncidents.
+// ============================================================================================= //
+#ifndef GS_TIMESTAMPMONITOR_H_
+#define GS_TIMESTAMPMONITOR_H_
+
+#include "GS_ChannelMap.h"
+#include "GS_Options.h"
+#include <TMath.h>
+#include <TString.h>
+#include <TTree.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+const Int_t    kTSMaxBoards = kMaxChannelId/10;
+const Long64_t kTSBackTolerance = 1000;		// Ticks a board may go back (GEBSort timewin)
+const Int_t    kTSBlock = 64;				// EBIS-coincident hits per offset median
+const Int_t    kTSLostWindow = 1024;		// EBIS events per window of the lost-board test
+const Int_t    kTSMaxIncidents = 10000;
+const Int_t    kTSPersist = 3;				// Blocks in a row off the offset for a jump
+const Double_t kTSSignificance = 5;			// Standard errors a block median must be off by
+
+enum TSIncidentKind { kTSBackward = 0, kTSOffset, kTSLost };
+
+typedef struct {
+	Int_t    Board;
+	Int_t    Kind;		// TSIncidentKind
+	Double_t Time;		// Seconds since the first timestamp of the run
+	Long64_t Size;		// Ticks: how far back, the change of offset, or the last offset for lost
+} TSIncident;
+
+class TimestampMonitor {
+public:
+	Long64_t JumpTicks;		// "tsjump=" threshold on the change of a board's EBIS offset
+	Bool_t   Align;			// "tsalign": shift the hits of a board back by its jumps
+	Double_t Tick;			// Length of one timestamp count in seconds
+
+	TimestampMonitor() : JumpTicks(50), Align(kFALSE), Tick(1e-8){ Clear(); }
+
+	void Configure( const TString &option ){
+		JumpTicks = GetOptionValue( option, "tsjump", "50" ).Atoll();
+		Align = HasOption( option, "tsalign" );
+	}
+
+	void Clear(){
+		for ( Int_t b = 0; b < kTSMaxBoards; b++ ){
+			fLast[b] = 0;
+			fHits[b] = fEBISHits[b] = 0;
+			fBackward[b] = fJumps[b] = fLost[b] = 0;
+			fLearned[b] = fBaseline[b] = fOffset[b] = fShift[b] = 0;
+			fBaseMAD[b] = 0;
+			fHaveBaseline[b] = kFALSE;
+			fNumOff[b] = 0;
+			fNumBlock[b] = 0;
+			fWindowHits[b] = fWindowCoinc[b] = fPrevCoinc[b] = 0;
+		}
+		fFirst = 0;
+		fHaveFirst = kFALSE;
+		fWindowEvents = 0;
+		fIncidents.clear();
+	}
+
+	// Check the hits of one event. With Align the timestamps are corrected in place, so call it
+	// after anything that needs the raw timestamps (the CFD pass) and before they are stored.
+	void Fill( const ChannelMap &map, Int_t n, const Short_t *id, ULong64_t *timestamp ){
+		// EBIS reference of the event, if it has one
+		Int_t ref = -1;
+		for ( Int_t i = 0; i < n; i++ ){
+			if ( map.Get( id[i] ).EBIS ){ ref = i; }
+		}
+		if ( n > 0 && !fHaveFirst ){
+			fFirst = timestamp[0];
+			fHaveFirst = kTRUE;
+		}
+
+		for ( Int_t i = 0; i < n; i++ ){
+			Int_t b = id[i]/10;
+			if ( b < 0 || b >= kTSMaxBoards ){ continue; }
+			timestamp[i] += fShift[b];
+			fHits[b]++;
+			fWindowHits[b]++;
+
+			// Monotonicity of the board's own clock
+			if ( fHits[b] > 1 && timestamp[i] + kTSBackTolerance < fLast[b] ){
+				fBackward[b]++;
+				AddIncident( b, kTSBackward, timestamp[i], (Long64_t)( fLast[b] - timestamp[i] ) );
+			}
+			fLast[b] = timestamp[i];
+
+			// Offset against the EBIS reference
+			if ( ref < 0 || i == ref ){ continue; }
+			fEBISHits[b]++;
+			fWindowCoinc[b]++;
+			fBlock[b][ fNumBlock[b]++ ] = (Long64_t)( timestamp[i] - timestamp[ref] );
+			if ( fNumBlock[b] == kTSBlock ){ EndBlock( b, timestamp[i] ); }
+		}
+
+		// Boards that dropped out of the EBIS events, once per window
+		if ( ref >= 0 && ++fWindowEvents == kTSLostWindow ){
+			for ( Int_t b = 0; b < kTSMaxBoards; b++ ){
+				if ( fPrevCoinc[b] >= 8 && fWindowCoinc[b] == 0 && fWindowHits[b] > 0 ){
+					fLost[b]++;
+					AddIncident( b, kTSLost, timestamp[ref], fOffset[b] );
+				}
+				fPrevCoinc[b] = fWindowCoinc[b];
+				fWindowCoinc[b] = fWindowHits[b] = 0;
+			}
+			fWindowEvents = 0;
+		}
+	}
+
+	Int_t NumIncidents() const { return fIncidents.size(); }
+
+	// Write ts_health and ts_jumps into the current directory
+	void Write() const {
+		Int_t board;
+		Long64_t hits, ebisHits, backward, jumps, lost, offset0, mad0, offset, shift;
+		TTree health( "ts_health", "Timestamp health per digitizer" );
+		health.Branch( "board", &board, "board/I" );
+		health.Branch( "hits", &hits, "hits/L" );
+		health.Branch( "ebis_hits", &ebisHits, "ebis_hits/L" );
+		health.Branch( "backward", &backward, "backward/L" );
+		health.Branch( "jumps", &jumps, "jumps/L" );
+		health.Branch( "lost", &lost, "lost/L" );
+		health.Branch( "offset0", &offset0, "offset0/L" );
+		health.Branch( "mad0", &mad0, "mad0/L" );
+		health.Branch( "offset", &offset, "offset/L" );
+		health.Branch( "shift", &shift, "shift/L" );
+		for ( board = 0; board < kTSMaxBoards; board++ ){
+			if ( fHits[board] == 0 ){ continue; }
+			hits = fHits[board];
+			ebisHits = fEBISHits[board];
+			backward = fBackward[board];
+			jumps = fJumps[board];
+			lost = fLost[board];
+			offset0 = fLearned[board];
+			mad0 = fBaseMAD[board];
+			offset = fOffset[board];
+			shift = fShift[board];
+			health.Fill();
+		}
+		health.Write( "", TObject::kOverwrite );
+
+		TSIncident inc;
+		TTree jumpTree( "ts_jumps", "Timestamp incidents" );
+		jumpTree.Branch( "board", &inc.Board, "board/I" );
+		jumpTree.Branch( "kind", &inc.Kind, "kind/I" );
+		jumpTree.Branch( "time", &inc.Time, "time/D" );
+		jumpTree.Branch( "size", &inc.Size, "size/L" );
+		for ( UInt_t i = 0; i < fIncidents.size(); i++ ){
+			inc = fIncidents[i];
+			jumpTree.Fill();
+		}
+		jumpTree.Write( "", TObject::kOverwrite );
+	}
+
+	// Boards with incidents, or a line saying there were none
+	void Print() const {
+		Bool_t header = kFALSE;
+		for ( Int_t b = 0; b < kTSMaxBoards; b++ ){
+			if ( fBackward[b] + fJumps[b] + fLost[b] == 0 ){ continue; }
+			if ( !header ){
+				printf("Timestamp incidents per digitizer:\n%6s %12s %10s %8s %8s %8s %10s %10s\n", "board",
+					"hits", "ebis_hits", "backward", "jumps", "lost", "offset", "shift" );
+				header = kTRUE;
+			}
+			printf("%6d %12lld %10lld %8lld %8lld %8lld %10lld %10lld\n", b, fHits[b], fEBISHits[b],
+				fBackward[b], fJumps[b], fLost[b], fOffset[b], fShift[b] );
+		}
+		if ( !header ){ printf("No timestamp jumps\n"); }
+		else if ( (Int_t)fIncidents.size() == kTSMaxIncidents ){ printf("(only the first %d incidents kept)\n", kTSMaxIncidents ); }
+	}
+
+private:
+	ULong64_t fLast[kTSMaxBoards];			// Last timestamp of each board
+	Long64_t  fHits[kTSMaxBoards];
+	Long64_t  fEBISHits[kTSMaxBoards];		// Hits in events with the EBIS reference
+	Long64_t  fBackward[kTSMaxBoards];
+	Long64_t  fJumps[kTSMaxBoards];
+	Long64_t  fLost[kTSMaxBoards];
+	Long64_t  fLearned[kTSMaxBoards];		// First block median
+	Long64_t  fBaseline[kTSMaxBoards];		// Offset the jumps are measured from
+	Long64_t  fBaseMAD[kTSMaxBoards];		// Median absolute deviation of the block it came from
+	Bool_t    fHaveBaseline[kTSMaxBoards];
+	Long64_t  fOffset[kTSMaxBoards];		// Latest block median
+	Long64_t  fShift[kTSMaxBoards];			// Added to the timestamps of the board with Align
+	Long64_t  fBlock[kTSMaxBoards][kTSBlock];
+	Int_t     fNumBlock[kTSMaxBoards];
+	Long64_t  fOff[kTSMaxBoards][kTSPersist];	// Medians of the blocks in a row off the offset
+	Int_t     fNumOff[kTSMaxBoards];
+	ULong64_t fOffSince[kTSMaxBoards];		// Timestamp of the first of them
+	Long64_t  fWindowHits[kTSMaxBoards];	// Hits and EBIS-coincident hits in the current window
+	Long64_t  fWindowCoinc[kTSMaxBoards];
+	Long64_t  fPrevCoinc[kTSMaxBoards];
+	ULong64_t fFirst;
+	Bool_t    fHaveFirst;
+	Int_t     fWindowEvents;
+	std::vector<TSIncident> fIncidents;
+
+	// Median of a full block, compared with the learned offset of the board
+	void EndBlock( Int_t b, ULong64_t timestamp ){
+		Long64_t *block = fBlock[b];
+		std::nth_element( block, block + kTSBlock/2, block + kTSBlock );
+		fOffset[b] = block[kTSBlock/2];
+		for ( Int_t i = 0; i < kTSBlock; i++ ){ block[i] = TMath::Abs( block[i] - fOffset[b] ); }
+		std::nth_element( block, block + kTSBlock/2, block + kTSBlock );
+		Long64_t mad = block[kTSBlock/2];
+		fNumBlock[b] = 0;
+		if ( !fHaveBaseline[b] ){
+			fLearned[b] = fBaseline[b] = fOffset[b];
+			fBaseMAD[b] = mad;
+			fHaveBaseline[b] = kTRUE;
+			return;
+		}
+
+		// Standard error of the difference of two block medians: 1.4826 MAD is the sigma of a
+		// normal distribution, and the median has 1.2533 sigma/sqrt(n)
+		Double_t error = 1.4826*1.2533*TMath::Sqrt( ( (Double_t)mad*mad + (Double_t)fBaseMAD[b]*fBaseMAD[b] )/kTSBlock );
+		Long64_t change = fOffset[b] - fBaseline[b];
+		Bool_t off = ( TMath::Abs( change ) >= JumpTicks && TMath::Abs( change ) > kTSSignificance*error );
+		if ( off && fNumOff[b] > 0 && ( change > 0 ) != ( fOff[b][0] > fBaseline[b] ) ){ fNumOff[b] = 0; }
+		if ( !off ){
+			fNumOff[b] = 0;
+			return;
+		}
+		if ( fNumOff[b] == 0 ){ fOffSince[b] = timestamp; }
+		fOff[b][ fNumOff[b]++ ] = fOffset[b];
+		if ( fNumOff[b] < kTSPersist ){ return; }
+
+		// Persistent: a jump by the median of the blocks that were off
+		std::nth_element( fOff[b], fOff[b] + kTSPersist/2, fOff[b] + kTSPersist );
+		change = fOff[b][kTSPersist/2] - fBaseline[b];
+		fNumOff[b] = 0;
+		fJumps[b]++;
+		AddIncident( b, kTSOffset, fOffSince[b], change );
+		if ( Align ){
+			fShift[b] -= change;
+			fLast[b] -= change;		// So the shift is not taken for a jump back
+		}
+		else{
+			fBaseline[b] += change;
+			fBaseMAD[b] = mad;
+		}
+	}
+
+	void AddIncident( Int_t b, Int_t kind, ULong64_t timestamp, Long64_t size ){
+		if ( (Int_t)fIncidents.size() >= kTSMaxIncidents ){ return; }
+		TSIncident inc = { b, kind, ( (Double_t)timestamp - (Double_t)fFirst )*Tick, size };
+		fIncidents.push_back( inc );
+	}
+};
+
+#endif
@@ -0,0 +1,76 @@
+// GS_TreeTuning.h
+// Compression and basket settings for the output trees (gen_tree, fin_tree), from the option
+// string rather than the ROOT defaults:
+//   compress=lz4:4       codec (zlib, lzma, lz4, zstd or none) and level, or a ROOT setting
+//                        number (100*algorithm + level, e.g. 505)
+//   basket=64000         basket size in bytes
+//   flush=-30000000      cluster size, as for TTree::SetAutoFlush: entries if > 0, bytes if < 0
+// apply to every branch, and compress.<branch>= / basket.<branch>= override them for one
+// branch, e.g. "compress=lz4:4 compress.e_t=zstd:5 basket.xcal=128000". Nothing given leaves
+// the tree as it was. benchmarks/BenchOutput.C measures the sizes and rates of such settings.
+// ============================================================================================= //
+#ifndef GS_TREETUNING_H_
+#define GS_TREETUNING_H_
+
+#include "GS_Options.h"
+#include <TBranch.h>
+#include <TFile.h>
+#include <TObjArray.h>
+#include <TString.h>
+#include <TTree.h>
+
+// ROOT compression setting for "codec:level" (or a setting number), -1 if none or not understood
+inline Int_t CompressionSetting( const TString &value ){
+	if ( value == "" ){ return -1; }
+	if ( value.IsDigit() ){ return value.Atoi(); }
+
+	TString codec = value, level = "";
+	Ssiz_t colon = value.Index(":");
+	if ( colon != kNPOS ){
+		codec = value( 0, colon );
+		level = value( colon + 1, value.Length() );
+	}
+	codec.ToLower();
+	if ( codec == "none" ){ return 0; }
+
+	// Algorithm numbers of ROOT::RCompressionSetting::EAlgorithm, with ROOT's usual level for each
+	Int_t algorithm = -1, defLevel = 1;
+	if ( codec == "zlib" ){ algorithm = 1; defLevel = 1; }
+	else if ( codec == "lzma" ){ algorithm = 2; defLevel = 8; }
+	else if ( codec == "lz4" ){ algorithm = 4; defLevel = 4; }
+	else if ( codec == "zstd" ){ algorithm = 5; defLevel = 5; }
+	if ( algorithm < 0 || ( level != "" && !level.IsDigit() ) ){
+		printf("Unknown compression \"%s\", keeping the default\n", value.Data() );
+		return -1;
+	}
+	return 100*algorithm + ( level != "" ? level.Atoi() : defLevel );
+}
+
+// Apply the options above to tree (already holding its branches) and the file it is written to
+inline void TuneTree( TFile *file, TTree *tree, const TString &option ){
+	Int_t compress = CompressionSetting( GetOptionValue( option, "compress" ) );
+	Int_t basket = GetOptionValue( option, "basket", "0" ).Atoi();
+	Long64_t flush = GetOptionValue( option, "flush", "0" ).Atoll();
+
+	if ( compress >= 0 && file ){ file->SetCompressionSettings( compress ); }
+	if ( basket > 0 ){ tree->SetBasketSize( "*", basket ); }
+	if ( flush != 0 ){ tree->SetAutoFlush( flush ); }
+
+	TObjArray *branches = tree->GetListOfBranches();
+	for ( Int_t i = 0; i < branches->GetEntries(); i++ ){
+		TBranch *b = (TBranch*)branches->At(i);
+		TString name = b->GetName();
+		Int_t c = CompressionSetting( GetOptionValue( option, "compress." + name ) );
+		if ( c < 0 ){ c = compress; }
+		if ( c >= 0 ){ b->SetCompressionSettings( c ); }
+		Int_t size = GetOptionValue( option, "basket." + name, "0" ).Atoi();
+		if ( size > 0 ){ b->SetBasketSize( size ); }
+	}
+
+	if ( compress >= 0 || basket > 0 || flush != 0 ){
+		printf("%s: compression %d, basket %d, auto-flush %lld\n", tree->GetName(),
+			( compress >= 0 ? compress : ( file ? file->GetCompressionSettings() : -1 ) ), basket, flush );
+	}
+}
+
+#endif
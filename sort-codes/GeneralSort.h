@@ -18,9 +18,50 @@
 #include <TH2.h>
 #include <TStopwatch.h>
 #include <TStyle.h>
+#include "GS_HitList.h"
+#include "GS_ChannelMap.h"
+#include "GS_RateMonitor.h"
+#include "GS_QuickLook.h"
+#include "GS_CFDTiming.h"
+#include "GS_HitFlags.h"
+#include "GS_TimestampMonitor.h"
+#include "GS_ChannelRates.h"
+#include "GS_TimeIndex.h"
 
 // Header file for the classes stored in the TTree if any.
 
+//PSD struct
+typedef struct {
+  Float_t Energy[100];
+  Float_t XF[100];
+  Float_t XN[100];
+  Float_t Ring[100];
+  Float_t RDT[100];
+  Float_t TAC[100];
+  Float_t ELUM[32];
+  Float_t EZERO[10];//0,1 - DE-E exit, 2,3 - DE-E atscat, 4 - ETOT
+// 2,3 - DEX,EX
+
+  ULong64_t EnergyTimestamp[100];
+  ULong64_t XFTimestamp[100];
+  ULong64_t XNTimestamp[100];
+  ULong64_t RingTimestamp[100];
+  ULong64_t RDTTimestamp[100];
+  ULong64_t TACTimestamp[100];
+  ULong64_t ELUMTimestamp[32];
+  ULong64_t EZEROTimestamp[10];
+  ULong64_t EBISTimestamp; 
+
+  Float_t EnergyFine[100];//CFD fine time in ticks, add to the timestamp (GS_CFDTiming.h)
+  Float_t RDTFine[100];
+
+  UChar_t EnergyFlag[100];//Tagged hit flags (GS_HitFlags.h), 0 for a clean or empty slot
+  UChar_t XFFlag[100];
+  UChar_t XNFlag[100];
+  UChar_t RDTFlag[100];
+
+} PSD;
+
 // Fixed size dimensions of array or collections stored in the TTree if any.
 
 class GeneralSort : public TSelector {
@@ -107,7 +148,54 @@ public :
    TBranch        *b_baseline;   //!
    TBranch        *b_trace_length;   //!
 
-   GeneralSort(TTree * /*tree*/ =0) : fChain(0) { }
+   // Sort state. Kept per instance (rather than as file globals) so that
+   // GeneralSortMT.C can run one sorter per entry range on separate threads.
+   PSD             psd;
+   HitList         hits;        // Hits of the event, written instead of psd with "format=hits"
+   TFile          *oFile;
+   TTree          *gen_tree;
+   RateMonitor     Rate;        // Events per wall-clock and per timestamp second, fixed size
+   TStopwatch      StpWatch;
+   ULong64_t       NumEntries;
+   ULong64_t       ProcessedEntries;
+   Float_t         Frac; //Progress bar
+   ChannelMap      ChanMap;     // Read from map.dat (or the "map=" option) in Begin
+   Float_t        *DestEnergy[kNumHitKinds];    // psd array each kind of hit is stored in
+   ULong64_t      *DestTimestamp[kNumHitKinds]; // ^^ timestamp
+   Float_t        *DestFine[kNumHitKinds];      // ^^ fine time, NULL for kinds without one
+   Float_t         FineTime[200];               // Fine time of each raw hit, from the CFD pass
+   UChar_t        *DestFlag[kNumHitKinds];      // ^^ tagged flags, NULL for kinds without them
+   UChar_t         HitFlag[200];                // Flags of each raw hit, from the flag pass
+   HitFlagMonitor  Flags;       // Hits and flags per channel, written as hFlags
+   TimestampMonitor TSMon;      // Timestamp jumps per digitizer, "tsjump=" and "tsalign" options
+   ChannelRates    ChanRates;   // rate_tree: per-channel rates, dead time and pile-up per time bucket
+   TString         OutFileName; // "out=" option, gen.root by default
+   Bool_t          Quiet;       // "quiet" option, no progress/summary printing
+   Bool_t          HitFormat;   // "format=hits" option, write the sparse hit-list layout
+   Bool_t          NoGen;       // "nogen" option, write no gen_tree (GeneralSortFused.C)
+   Bool_t          Failed;      // Begin could not set up the sort (see Abort), nothing is sorted or written
+   QuickLook       Quick;       // prescale=, sample=, tmin=/tmax= and max= options
+   Bool_t          UseCFD;      // Raw tree has CFD words and no "nocfd" option: write e_ft/rdt_ft
+   Bool_t          UseFlags;    // Raw tree has the hit flags
+   Bool_t          UseRates;    // rate_tree is written, unless "norates" is given
+   TimeIndexBuilder TSIndex;    // ts_index of gen_tree, one point per "tsindex=" entries
+   UInt_t          RejectMask;  // "reject=" flags, hits with any of them are dropped
+   UInt_t          TagMask;     // "tag=" flags, written with the hits
+
+   // Sorter configuration. The defaults below are GeneralSort's; a derived sorter (inflightSort)
+   // sets its own in its constructor, and "kinds=" overrides KindMask at start-up.
+   UInt_t          KindMask;    // Detector kinds sorted, bit (1 << HitKind) per kind
+   Int_t           NumSortKinds;
+   Int_t           SortKinds[kNumHitKinds];     // The kinds in KindMask, set in Begin
+   TString         TreeName;    // Name of the output tree
+   TString         DefaultOutFile; // Output file without "out="
+   TString         DefaultMapFile; // Channel map without "map="
+
+   GeneralSort(TTree * /*tree*/ =0) : fChain(0), oFile(0), gen_tree(0),
+      NumEntries(0), ProcessedEntries(0), Frac(0.1), OutFileName("gen.root"), Quiet(kFALSE),
+      HitFormat(kFALSE), NoGen(kFALSE), Failed(kFALSE), UseCFD(kFALSE), UseFlags(kFALSE), UseRates(kFALSE), RejectMask(0), TagMask(0),
+      KindMask(kAllHitKinds), NumSortKinds(0), TreeName("gen_tree"), DefaultOutFile("gen.root"),
+      DefaultMapFile("map.dat") { }
    virtual ~GeneralSort() { }
    virtual Int_t   Version() const { return 2; }
    virtual void    Begin(TTree *tree);
@@ -123,6 +211,9 @@ public :
    virtual void    SlaveTerminate();
    virtual void    Terminate();
 
+   Bool_t          SortEvent();
+   void            StoreHit(Int_t kind, Int_t det, Float_t energy, ULong64_t timestamp, Float_t fine, UChar_t flag);
+
    ClassDef(GeneralSort,0);
 };
 
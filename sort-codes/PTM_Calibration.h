@@ -0,0 +1,185 @@
+// PTM_Calibration.h
+// Calibration constants of PTMonitors with run-range validity, read from a text file at start-up
+// ("calib=", calib.dat by default, see working/calib.dat), so that new constants need no
+// recompile and different runs can have different ones. One line per detector and table:
+//   runs  table  index  value [value ...]
+// where runs is first-last, first- (no end), a single run or * (every run), table is the name of
+// the array in PTMonitors (xnCorr, eCorr, ...), index the detector (or row) and the values its
+// columns. The run is taken from the name of the input file (gen_run25.root), or "run=". For a
+// given run the lines are applied in file order, so a later line overrides an earlier one, e.g.
+// a * line for a detector followed by its recalibration for runs 40-.
+// Apply() copies the constants of the run into the arrays PTMonitors already uses in its event
+// loop, so the loop reads plain contiguous arrays and there are no look-ups per event. Constants
+// not in the file keep their compiled-in values.
+// ============================================================================================= //
+#ifndef PTM_CALIBRATION_H_
+#define PTM_CALIBRATION_H_
+
+#include <TString.h>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const Int_t kCalibAnyRun = -1;	// Run number when it is not known, only * lines apply
+
+// Run number of a file such as gen_run25.root (the digits before .root), or kCalibAnyRun
+inline Int_t RunNumberFromFileName( TString name ){
+	if ( name.Last('/') != kNPOS ){ name.Remove( 0, name.Last('/') + 1 ); }
+	if ( name.EndsWith(".root") ){ name.Remove( name.Length() - 5 ); }
+	Int_t start = name.Length();
+	while ( start > 0 && isdigit( name[start-1] ) ){ start--; }
+	if ( start == name.Length() ){ return kCalibAnyRun; }
+	return atoi( name.Data() + start );
+}
+
+typedef struct {
+	Int_t                 First, Last;	// Runs the line is valid for, Last -1 for no end
+	Bool_t                AnyRun;		// * (also applied when the run is not known)
+	std::string           Table;
+	Int_t                 Index;
+	std::vector<Double_t> Values;
+	Int_t                 Line;			// In the file, for the messages
+} CalibrationEntry;
+
+class CalibrationStore {
+public:
+	TString FileName;
+	Int_t   Run;		// Run the constants are taken for
+	Int_t   NumSet;		// Constants (detectors) set by Apply so far
+
+	CalibrationStore() : Run( kCalibAnyRun ), NumSet(0) {}
+
+	Bool_t Load( const TString &fileName ){
+		fEntries.clear();
+		fUsed.clear();
+		FileName = fileName;
+		std::ifstream in( fileName.Data() );
+		if ( !in.is_open() ){
+			printf("Cannot open calibration file %s\n", fileName.Data() );
+			return kFALSE;
+		}
+
+		std::string line;
+		Int_t lineNum = 0;
+		while ( std::getline( in, line ) ){
+			lineNum++;
+			if ( line.find('#') != std::string::npos ){ line = line.substr( 0, line.find('#') ); }
+			std::istringstream words( line );
+			std::string runs;
+			if ( !( words >> runs ) ){ continue; }	// Blank or comment line
+
+			CalibrationEntry entry;
+			entry.Line = lineNum;
+			Double_t v;
+			Bool_t ok = ParseRuns( runs, entry ) && ( words >> entry.Table >> entry.Index ) && entry.Index >= 0;
+			while ( words >> v ){ entry.Values.push_back( v ); }
+			if ( !ok || entry.Values.empty() || !words.eof() ){
+				printf("Bad line %d in calibration file %s: %s\n", lineNum, fileName.Data(), line.c_str() );
+				fEntries.clear();
+				return kFALSE;
+			}
+			fEntries.push_back( entry );
+		}
+		fUsed.assign( fEntries.size(), kFALSE );
+		printf("Read %d calibration lines from %s\n", (Int_t)fEntries.size(), fileName.Data() );
+		if ( Run == kCalibAnyRun ){
+			Int_t numRanged = 0;
+			for ( UInt_t i = 0; i < fEntries.size(); i++ ){ numRanged += !fEntries[i].AnyRun; }
+			if ( numRanged > 0 ){
+				printf("Warning: the run is not known (give run=), so the %d run-range lines of %s are not applied\n",
+					numRanged, fileName.Data() );
+			}
+		}
+		return kTRUE;
+	}
+
+	// Copy the constants of table for the run into dest[n][width], and mark its lines as used.
+	// Returns the number of rows set.
+	template<class T>
+	Int_t Apply( const char *table, T *dest, Int_t n, Int_t width = 1 ){
+		std::vector<Bool_t> set( n, kFALSE );
+		for ( UInt_t i = 0; i < fEntries.size(); i++ ){
+			CalibrationEntry &entry = fEntries[i];
+			if ( entry.Table != table ){ continue; }
+			fUsed[i] = kTRUE;
+			if ( entry.Index >= n || (Int_t)entry.Values.size() != width ){
+				printf("Calibration %s line %d: %s takes index 0-%d and %d value(s), ignored\n",
+					FileName.Data(), entry.Line, table, n - 1, width );
+				continue;
+			}
+			if ( !Covers( entry ) ){ continue; }
+			for ( Int_t j = 0; j < width; j++ ){ dest[ entry.Index*width + j ] = (T)entry.Values[j]; }
+			set[ entry.Index ] = kTRUE;
+		}
+		Int_t num = 0;
+		for ( Int_t i = 0; i < n; i++ ){ num += set[i]; }
+		if ( num > 0 ){ printf("  %-14s %2d of %d from %s\n", table, num, n, FileName.Data() ); }
+		NumSet += num;
+		return num;
+	}
+
+	// Mark the lines of table as used without applying them, for constants set elsewhere.
+	// Returns the number of them valid for the run.
+	Int_t Skip( const char *table ){
+		Int_t num = 0;
+		for ( UInt_t i = 0; i < fEntries.size(); i++ ){
+			if ( fEntries[i].Table != table ){ continue; }
+			fUsed[i] = kTRUE;
+			num += Covers( fEntries[i] );
+		}
+		return num;
+	}
+
+	// Report the tables neither Apply nor Skip asked for, most likely misspelt names, once each
+	void CheckTables() const {
+		std::vector<std::string> reported;
+		for ( UInt_t i = 0; i < fEntries.size(); i++ ){
+			if ( fUsed[i] ){ continue; }
+			const std::string &table = fEntries[i].Table;
+			Bool_t seen = kFALSE;
+			for ( UInt_t k = 0; k < reported.size(); k++ ){ seen |= ( reported[k] == table ); }
+			if ( seen ){ continue; }
+			printf("Calibration %s line %d: no table %s, its lines are ignored\n", FileName.Data(), fEntries[i].Line, table.c_str() );
+			reported.push_back( table );
+		}
+	}
+
+	// For the output file, e.g. "calib.dat run 25"
+	TString Description() const {
+		if ( fEntries.empty() ){ return "built-in"; }
+		return FileName + ( Run == kCalibAnyRun ? TString(" (run unknown)") : Form( " run %d", Run ) );
+	}
+
+private:
+	std::vector<CalibrationEntry> fEntries;
+	std::vector<Bool_t>           fUsed;	// Lines of the tables asked for
+
+	Bool_t Covers( const CalibrationEntry &entry ) const {
+		if ( entry.AnyRun ){ return kTRUE; }
+		if ( Run == kCalibAnyRun ){ return kFALSE; }
+		return ( Run >= entry.First && ( entry.Last < 0 || Run <= entry.Last ) );
+	}
+
+	static Bool_t ParseRuns( const std::string &runs, CalibrationEntry &entry ){
+		entry.AnyRun = ( runs == "*" );
+		entry.First = 0; entry.Last = -1;
+		if ( entry.AnyRun ){ return kTRUE; }
+		size_t dash = runs.find('-');
+		if ( dash == 0 ){ return kFALSE; }
+		std::string first = runs.substr( 0, dash ), last = ( dash == std::string::npos ? first : runs.substr( dash + 1 ) );
+		if ( first.find_first_not_of("0123456789") != std::string::npos ){ return kFALSE; }
+		if ( last.find_first_not_of("0123456789") != std::string::npos ){ return kFALSE; }
+		entry.First = atoi( first.c_str() );
+		if ( !last.empty() ){
+			entry.Last = atoi( last.c_str() );
+			if ( entry.Last < entry.First ){ return kFALSE; }
+		}
+		return kTRUE;
+	}
+};
+
+#endif
@@ -0,0 +1,537 @@
+// PTM_Kinematics.h
+// Ex and thetaCM of a light particle on the array from its energy and z, for PTMonitors. The exact
+// solve (Ryan's: Newton-Raphson on H sin(phi) - G tan(phi) - Z = 0 for the cyclotron phase) depends
+// only on (E, z) and the reaction constants, so each reaction hypothesis gets a grid of its
+// solutions over E and z, built once and cached in a ROOT file ("kingrid=", kingrid.root by default),
+// and every hit is then a bilinear interpolation in its cell instead of an iteration. The hits
+// left to the exact solve are solved together, all hypotheses in one batch (KinematicsBatch).
+//
+// Every cell is checked against the exact solve on a lattice of kKinCheck x kKinCheck points over
+// it, corners and edges included (its centre, the midpoints and quarter points of its edges, ...).
+// A cell is interpolated only if all its corners and check points have a solution and the
+// interpolation is within half of kKinExTolerance (MeV) and kKinThetaTolerance (degrees) of the
+// exact solve at all of them, so that the error between the check points stays within them.
+// Other cells (the edge of the physical region, where the solution is not smooth) and points
+// outside the grid go to the exact solve, as does everything with "nokingrid".
+// The grid is kept under the name of the hypothesis and a hash of its constants and ranges, so a
+// change of the reaction or of the array radius builds (and caches) a new one. The cache is
+// rewritten whole into a temporary file that is then renamed over it, so runs sorted at the same
+// time never read a half-written file.
+//
+// The hypotheses themselves come from a table (ReactionTable, "reactions=", reactions.dat by
+// default), one line per hypothesis, and all of them go through the same grids and batch solve.
+// ============================================================================================= //
+#ifndef PTM_KINEMATICS_H_
+#define PTM_KINEMATICS_H_
+
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TH2.h>
+#include <TKey.h>
+#include <TMath.h>
+#include <TNamed.h>
+#include <TParameter.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Grid ranges and steps, with E in MeV and z in cm as in fin_tree
+const Double_t kKinEMin = 0, kKinEMax = 15, kKinEStep = 0.02;
+const Double_t kKinZMin = -60, kKinZMax = 0, kKinZStep = 0.1;
+const Double_t kKinExTolerance = 0.001;			// Largest interpolation error kept [MeV]
+const Double_t kKinThetaTolerance = 0.05;		// [deg]
+const Int_t    kKinCheck = 5;					// Check points along each side of a cell
+const Int_t    kMaxHypotheses = 8;				// Reaction hypotheses in a ReactionTable
+
+class Reaction {
+public:
+	Double_t alpha, beta, gamm, G, massB, mass, Et;		// Variables for the Ex calculation
+
+	Reaction() : alpha(0), beta(0), gamm(1), G(0), massB(0), mass(0), Et(0) {}
+
+	// From the constants { mass of b, charge of b, CM total energy, mass of B, beta to CM frame,
+	// B field } of a hypothesis (exCorr) and the distance of the detectors to the axis [mm]
+	void Set( const Float_t *c, Double_t radius ){
+		alpha = 299.792458 * c[5] * c[1] / TMath::TwoPi() / 1000; //MeV/mm
+		beta = c[4];
+		gamm = 1./TMath::Sqrt(1-beta*beta);
+		G = alpha*gamm*beta*radius;
+		massB = c[3];
+		mass = c[0];
+		Et = c[2];
+	}
+
+	// Exact solve for the calibrated energy e [MeV] at z [cm]. Returns kFALSE if there is no
+	// solution, with ex and thetaCM left NaN.
+	Bool_t Solve( Double_t e, Double_t z, Double_t &ex, Double_t &thetaCM ) const {
+		ex = thetaCM = TMath::QuietNaN();
+		double y = e + mass; // to give the KE + mass of proton;
+		double Z = alpha * gamm * beta * z * 10.;
+		double H = TMath::Sqrt(TMath::Power(gamm * beta,2) * (y*y - mass * mass) ) ;
+		if( !( TMath::Abs(Z) < H ) ){ return kFALSE; }
+
+		// Use Newton's method to solve 0 ==  H * sin(phi) - G * tan(phi) - Z = f(phi)
+		double tolerance = 0.001;	// Desired precision
+		double phi = 0; 			// Initial phi = 0 -> ensure the solution has f'(phi) > 0
+		double nPhi = 0; 			// New phi
+		int iter = 0;				// Number of iterations
+		do{
+			phi = nPhi;
+			nPhi = phi - (H * TMath::Sin(phi) - G * TMath::Tan(phi) - Z) / (H * TMath::Cos(phi) - G /TMath::Power( TMath::Cos(phi), 2));
+			iter ++;
+			if( iter > 10 || TMath::Abs(nPhi) > TMath::PiOver2()) break;
+		} while( TMath::Abs(phi - nPhi ) > tolerance);
+		phi = nPhi;
+
+		// Check f'(phi) > 0
+		double Df = H * TMath::Cos(phi) - G / TMath::Power( TMath::Cos(phi),2);
+		if( !( Df > 0 && TMath::Abs(phi) < TMath::PiOver2() ) ){ return kFALSE; }
+
+		// Found correct value of phi - now calculate everything else
+		double K = H * TMath::Sin(phi);
+		double x = TMath::ACos( mass / ( y * gamm - K));
+		double momt = mass * TMath::Tan( x ); // momentum of particle b or B in CM frame
+		double EB = TMath::Sqrt(mass*mass + Et*Et - 2*Et*TMath::Sqrt(momt * momt + mass * mass));
+		ex = EB - massB;
+		double hahaha1 = gamm* TMath::Sqrt(mass * mass + momt * momt) - y;
+		double hahaha2 = gamm* beta * momt;
+		thetaCM = TMath::ACos(hahaha1/hahaha2) * TMath::RadToDeg();
+		return kTRUE;
+	}
+
+	// Everything the solutions depend on, to name the cached grid by
+	TString Key() const {
+		return Form( "%.9g %.9g %.9g %.9g %.9g %.9g %.9g", alpha, beta, G, massB, mass, Et, gamm );
+	}
+};
+
+// Batched exact solve. Hits are queued with Add(), each under its own reaction hypothesis, as
+// structure-of-arrays lanes, and Solve() runs the Newton-Raphson of all of them in lock-step: every
+// step is taken for every lane, with a 0/1 mask freezing the lanes that have converged or left
+// (-pi/2, pi/2), until none is left or the 11 steps of Reaction::Solve are done. The lane loops
+// have no control flow, so the arithmetic in them vectorises in an optimising compile (ACLiC "+O",
+// -O3), but sin and acos stay one scalar libm call per lane: GCC only uses the vector maths
+// library (libmvec) under -ffast-math, which cannot be used as the NaNs are needed. The gain
+// over Reaction::Solve (about 1.6x in benchmarks/BenchKinematics.C) is from the branch-free
+// lock-step loops and one sin per step instead of sin, cos and tan, not from vector sin/acos.
+// The results are those of Reaction::Solve to rounding.
+// Queue all the hits of an event, or of a block of events, for every hypothesis, then call
+// Solve() once; it also runs by itself each kKinBatch lanes.
+const Int_t kKinBatch = 64;
+
+class KinematicsBatch {
+public:
+	Long64_t NumSolved;
+
+	KinematicsBatch() : NumSolved(0), fN(0) {}
+
+	// Queue hit (e, z) under reaction r, to have its Ex and thetaCM (NaN for no solution) in *ex
+	// and *thetaCM after Solve()
+	void Add( const Reaction &r, Double_t e, Double_t z, Float_t *ex, Float_t *thetaCM ){
+		fY[fN] = e + r.mass;
+		fZ[fN] = z;
+		fAlpha[fN] = r.alpha;
+		fBeta[fN] = r.beta;
+		fGamm[fN] = r.gamm;
+		fG[fN] = r.G;
+		fMass[fN] = r.mass;
+		fMassB[fN] = r.massB;
+		fEt[fN] = r.Et;
+		fEx[fN] = ex;
+		fTheta[fN] = thetaCM;
+		if ( ++fN == kKinBatch ){ Solve(); }
+	}
+
+	void Solve(){
+		if ( fN == 0 ){ return; }
+		const Double_t nan = TMath::QuietNaN();
+		const Double_t tolerance = 0.001;	// As Reaction::Solve
+		Double_t Z[kKinBatch], H[kKinBatch], phi[kKinBatch], ex[kKinBatch], theta[kKinBatch];
+		Int_t valid[kKinBatch], active[kKinBatch];
+		Int_t n = fN;
+
+		for ( Int_t i = 0; i < n; i++ ){
+			Z[i] = fAlpha[i] * fGamm[i] * fBeta[i] * fZ[i] * 10.;
+			H[i] = TMath::Sqrt(TMath::Power(fGamm[i] * fBeta[i],2) * (fY[i]*fY[i] - fMass[i] * fMass[i]) ) ;
+			valid[i] = ( TMath::Abs(Z[i]) < H[i] );
+			active[i] = valid[i];
+			phi[i] = 0;
+		}
+
+		// Newton-Raphson on 0 == H * sin(phi) - G * tan(phi) - Z, in lock-step. The lanes still
+		// iterating have |phi| < pi/2, so cos(phi) = sqrt(1 - sin^2), a vectorised sqrt in place
+		// of a second libm call
+		Int_t any = 1;
+		for ( Int_t iter = 0; iter < 11 && any; iter++ ){
+			any = 0;
+			for ( Int_t i = 0; i < n; i++ ){
+				Double_t sn = TMath::Sin(phi[i]), cs = TMath::Sqrt( 1 - sn*sn );
+				Double_t nPhi = phi[i] - (H[i] * sn - fG[i] * sn/cs - Z[i]) / (H[i] * cs - fG[i] /( cs*cs ));
+				Int_t stop = ( TMath::Abs(nPhi) > TMath::PiOver2() ) | ( TMath::Abs(phi[i] - nPhi) <= tolerance );
+				phi[i] = ( active[i] ? nPhi : phi[i] );
+				active[i] &= !stop;
+				any |= active[i];
+			}
+		}
+
+		// Everything else, kept where f'(phi) > 0. With u = mass / ( y * gamm - K ),
+		// tan( acos( u ) ) = sqrt( 1 - u^2 )/u
+		for ( Int_t i = 0; i < n; i++ ){
+			Double_t sn = TMath::Sin(phi[i]), cs = TMath::Sqrt( 1 - sn*sn );
+			Double_t Df = H[i] * cs - fG[i] / ( cs*cs );
+			Int_t ok = valid[i] & ( Df > 0 ) & ( TMath::Abs(phi[i]) < TMath::PiOver2() );
+			Double_t K = H[i] * sn;
+			Double_t u = fMass[i] / ( fY[i] * fGamm[i] - K);
+			Double_t momt = fMass[i] * TMath::Sqrt( 1 - u*u )/u; // momentum of particle b or B in CM frame
+			Double_t EB = TMath::Sqrt(fMass[i]*fMass[i] + fEt[i]*fEt[i] - 2*fEt[i]*TMath::Sqrt(momt * momt + fMass[i] * fMass[i]));
+			Double_t h1 = fGamm[i]* TMath::Sqrt(fMass[i] * fMass[i] + momt * momt) - fY[i];
+			Double_t h2 = fGamm[i]* fBeta[i] * momt;
+			ex[i] = ( ok ? EB - fMassB[i] : nan );
+			theta[i] = ( ok ? TMath::ACos(h1/h2) * TMath::RadToDeg() : nan );
+		}
+
+		for ( Int_t i = 0; i < n; i++ ){
+			*fEx[i] = ex[i];
+			*fTheta[i] = theta[i];
+		}
+		NumSolved += n;
+		fN = 0;
+	}
+
+private:
+	Int_t    fN;					// Lanes queued
+	Double_t fY[kKinBatch];			// E + mass
+	Double_t fZ[kKinBatch];
+	Double_t fAlpha[kKinBatch], fBeta[kKinBatch], fGamm[kKinBatch], fG[kKinBatch];
+	Double_t fMass[kKinBatch], fMassB[kKinBatch], fEt[kKinBatch];
+	Float_t *fEx[kKinBatch], *fTheta[kKinBatch];
+};
+
+class KinematicsGrid {
+public:
+	Bool_t   Use;						// kFALSE for the exact solve everywhere ("nokingrid")
+	Long64_t NumGrid, NumExact;			// Hits interpolated and solved exactly
+	Double_t MaxExError, MaxThetaError;	// Largest error at the check points of the kept cells
+
+	KinematicsGrid() : Use(kFALSE), NumGrid(0), NumExact(0), MaxExError(0), MaxThetaError(0),
+		fNE( TMath::Nint( ( kKinEMax - kKinEMin )/kKinEStep ) + 1 ),
+		fNZ( TMath::Nint( ( kKinZMax - kKinZMin )/kKinZStep ) + 1 ), fNumCells(0) {}
+
+	// Take the grid of reaction r from the cache file, or build it and add it there. name is that
+	// of the hypothesis (e.g. "mg"). With cacheName "" or "none" the grid is built but not kept.
+	void Build( const Reaction &r, const char *name, const TString &cacheName, Bool_t use = kTRUE ){
+		fReac = r;
+		Use = use;
+		NumGrid = NumExact = 0;
+		if ( !Use ){ return; }
+
+		TString key = Form( "%s|%d %g %g|%d %g %g|%g %g %d", r.Key().Data(), fNE, kKinEMin, kKinEStep,
+			fNZ, kKinZMin, kKinZStep, kKinExTolerance/2, kKinThetaTolerance/2, kKinCheck );
+		TString gridName = Form( "kin_%s_%08x", name, key.Hash() );
+		Bool_t keep = ( cacheName != "" && cacheName != "none" );
+
+		TDirectory::TContext context;		// Leave gDirectory as it was
+		if ( keep && Load( cacheName, gridName ) ){
+			printf("Kinematics grid %s from %s: ", gridName.Data(), cacheName.Data() );
+		}
+		else{
+			Fill();
+			printf("Kinematics grid %s built: ", gridName.Data() );
+			if ( keep ){ Save( cacheName, gridName, key ); }
+		}
+		printf("%.1f%% of %d cells interpolated, max error %.2g keV and %.2g deg, the rest solved exactly\n",
+			100.*fNumCells/( ( fNE - 1 )*( fNZ - 1 ) ), ( fNE - 1 )*( fNZ - 1 ), MaxExError*1000, MaxThetaError );
+	}
+
+	// Ex and thetaCM of a hit, from the grid where its cell passed the check and exactly otherwise
+	Bool_t Eval( Double_t e, Double_t z, Double_t &ex, Double_t &thetaCM ){
+		if ( Use ){
+			Double_t u = ( e - kKinEMin )/kKinEStep, v = ( z - kKinZMin )/kKinZStep;
+			if ( u >= 0 && u < fNE - 1 && v >= 0 && v < fNZ - 1 ){
+				Int_t i = (Int_t)u, j = (Int_t)v;
+				if ( fCell[ i*( fNZ - 1 ) + j ] ){
+					Interpolate( i, j, u - i, v - j, ex, thetaCM );
+					NumGrid++;
+					return kTRUE;
+				}
+			}
+		}
+		NumExact++;
+		return fReac.Solve( e, z, ex, thetaCM );
+	}
+
+	// Ex and thetaCM of n hits (e.g. the 24 detectors of an event): the hits in interpolated cells
+	// are done here, hits without an energy or z get NaN, and the rest are queued on batch, to be
+	// solved exactly with batch.Solve() together with those of the other hypotheses
+	void EvalBatch( Int_t n, const Float_t *e, const Float_t *z, Float_t *ex, Float_t *thetaCM,
+		KinematicsBatch &batch ){
+		for ( Int_t k = 0; k < n; k++ ){
+			if ( TMath::IsNaN( e[k] ) || TMath::IsNaN( z[k] ) ){
+				ex[k] = thetaCM[k] = TMath::QuietNaN();
+				continue;
+			}
+			Double_t u = ( e[k] - kKinEMin )/kKinEStep, v = ( z[k] - kKinZMin )/kKinZStep;
+			if ( Use && u >= 0 && u < fNE - 1 && v >= 0 && v < fNZ - 1 ){
+				Int_t i = (Int_t)u, j = (Int_t)v;
+				if ( fCell[ i*( fNZ - 1 ) + j ] ){
+					Double_t exGrid, thGrid;
+					Interpolate( i, j, u - i, v - j, exGrid, thGrid );
+					ex[k] = exGrid;
+					thetaCM[k] = thGrid;
+					NumGrid++;
+					continue;
+				}
+			}
+			batch.Add( fReac, e[k], z[k], &ex[k], &thetaCM[k] );
+			NumExact++;
+		}
+	}
+
+	void PrintUsage( const char *name ) const {
+		if ( !Use ){ return; }
+		printf("Kinematics %s: %lld hits from the grid, %lld solved exactly\n", name, NumGrid, NumExact );
+	}
+
+private:
+	Reaction fReac;
+	Int_t    fNE, fNZ;					// Nodes along E and z
+	Int_t    fNumCells;					// Cells interpolated
+	std::vector<Float_t> fEx, fTheta;	// Solutions at the nodes, [iE*fNZ + iZ]
+	std::vector<UChar_t> fCell;			// 1 if the cell is interpolated, [iE*(fNZ-1) + iZ]
+
+	void Interpolate( Int_t i, Int_t j, Double_t fu, Double_t fv, Double_t &ex, Double_t &thetaCM ) const {
+		Int_t k = i*fNZ + j;
+		Double_t w00 = ( 1 - fu )*( 1 - fv ), w01 = ( 1 - fu )*fv, w10 = fu*( 1 - fv ), w11 = fu*fv;
+		ex = w00*fEx[k] + w01*fEx[k+1] + w10*fEx[k+fNZ] + w11*fEx[k+fNZ+1];
+		thetaCM = w00*fTheta[k] + w01*fTheta[k+1] + w10*fTheta[k+fNZ] + w11*fTheta[k+fNZ+1];
+	}
+
+	// Solve at the nodes, then check every cell
+	void Fill(){
+		fEx.assign( fNE*fNZ, 0 );
+		fTheta.assign( fNE*fNZ, 0 );
+		for ( Int_t i = 0; i < fNE; i++ ){
+			for ( Int_t j = 0; j < fNZ; j++ ){
+				Double_t ex, th;
+				fReac.Solve( kKinEMin + i*kKinEStep, kKinZMin + j*kKinZStep, ex, th );
+				fEx[ i*fNZ + j ] = ex;
+				fTheta[ i*fNZ + j ] = th;
+			}
+		}
+		Check();
+	}
+
+	// Every point of the kKinCheck x kKinCheck lattice over each cell but the corners (the nodes)
+	void Check(){
+		std::vector<Double_t> pu, pv;
+		for ( Int_t a = 0; a < kKinCheck; a++ ){
+			for ( Int_t b = 0; b < kKinCheck; b++ ){
+				if ( ( a == 0 || a == kKinCheck - 1 ) && ( b == 0 || b == kKinCheck - 1 ) ){ continue; }
+				pu.push_back( (Double_t)a/( kKinCheck - 1 ) );
+				pv.push_back( (Double_t)b/( kKinCheck - 1 ) );
+			}
+		}
+		fCell.assign( ( fNE - 1 )*( fNZ - 1 ), 0 );
+		fNumCells = 0;
+		MaxExError = MaxThetaError = 0;
+		for ( Int_t i = 0; i < fNE - 1; i++ ){
+			for ( Int_t j = 0; j < fNZ - 1; j++ ){
+				Int_t k = i*fNZ + j;
+				if ( TMath::IsNaN( fEx[k] ) || TMath::IsNaN( fEx[k+1] ) || TMath::IsNaN( fEx[k+fNZ] ) ||
+					TMath::IsNaN( fEx[k+fNZ+1] ) ){ continue; }
+				Bool_t good = kTRUE;
+				Double_t dEx = 0, dTheta = 0;
+				for ( UInt_t p = 0; p < pu.size() && good; p++ ){
+					Double_t ex, th, exGrid, thGrid;
+					good = fReac.Solve( kKinEMin + ( i + pu[p] )*kKinEStep, kKinZMin + ( j + pv[p] )*kKinZStep, ex, th );
+					Interpolate( i, j, pu[p], pv[p], exGrid, thGrid );
+					dEx = TMath::Max( dEx, TMath::Abs( exGrid - ex ) );
+					dTheta = TMath::Max( dTheta, TMath::Abs( thGrid - th ) );
+					good = good && dEx < kKinExTolerance/2 && dTheta < kKinThetaTolerance/2;
+				}
+				if ( !good ){ continue; }
+				fCell[ i*( fNZ - 1 ) + j ] = 1;
+				fNumCells++;
+				MaxExError = TMath::Max( MaxExError, dEx );
+				MaxThetaError = TMath::Max( MaxThetaError, dTheta );
+			}
+		}
+	}
+
+	// The nodes and the cell flags are kept as histograms over E and z (<name>_ex, _theta, _cell),
+	// and the largest errors at the check points as <name>_exerr [MeV] and _thetaerr [deg]
+	Bool_t Load( const TString &cacheName, const TString &gridName ){
+		if ( gSystem->AccessPathName( cacheName ) ){ return kFALSE; }
+		TFile f( cacheName );
+		TH2F *hEx = (TH2F*)f.Get( gridName + "_ex" );
+		TH2F *hTheta = (TH2F*)f.Get( gridName + "_theta" );
+		TH2C *hCell = (TH2C*)f.Get( gridName + "_cell" );
+		if ( !hEx || !hTheta || !hCell || hEx->GetNbinsX() != fNE || hEx->GetNbinsY() != fNZ ){ return kFALSE; }
+		fEx.resize( fNE*fNZ );
+		fTheta.resize( fNE*fNZ );
+		for ( Int_t i = 0; i < fNE; i++ ){
+			for ( Int_t j = 0; j < fNZ; j++ ){
+				fEx[ i*fNZ + j ] = hEx->GetBinContent( i + 1, j + 1 );
+				fTheta[ i*fNZ + j ] = hTheta->GetBinContent( i + 1, j + 1 );
+			}
+		}
+		fCell.assign( ( fNE - 1 )*( fNZ - 1 ), 0 );
+		fNumCells = 0;
+		for ( Int_t i = 0; i < fNE - 1; i++ ){
+			for ( Int_t j = 0; j < fNZ - 1; j++ ){
+				fCell[ i*( fNZ - 1 ) + j ] = ( hCell->GetBinContent( i + 1, j + 1 ) > 0 );
+				fNumCells += fCell[ i*( fNZ - 1 ) + j ];
+			}
+		}
+		TParameter<Double_t> *exErr = (TParameter<Double_t>*)f.Get( gridName + "_exerr" );
+		TParameter<Double_t> *thetaErr = (TParameter<Double_t>*)f.Get( gridName + "_thetaerr" );
+		MaxExError = ( exErr ? exErr->GetVal() : kKinExTolerance );
+		MaxThetaError = ( thetaErr ? thetaErr->GetVal() : kKinThetaTolerance );
+		return kTRUE;
+	}
+
+	// The other grids of the cache are copied into a new file with this one, which then replaces
+	// the cache. Of two runs saving at once, the grid of the first to finish is dropped from the
+	// cache (and built again when next needed), but neither sees a partial file.
+	void Save( const TString &cacheName, const TString &gridName, const TString &key ) const {
+		TString tmpName = Form( "%s.%d.tmp", cacheName.Data(), gSystem->GetPid() );
+		TFile f( tmpName, "RECREATE" );
+		if ( !f.IsOpen() ){
+			printf("Cannot write the kinematics grid to %s\n", tmpName.Data() );
+			return;
+		}
+		if ( !gSystem->AccessPathName( cacheName ) ){
+			TFile old( cacheName );
+			TIter next( old.GetListOfKeys() );
+			while ( TKey *k = (TKey*)next() ){
+				if ( TString( k->GetName() ).BeginsWith( gridName ) || f.GetKey( k->GetName() ) ){ continue; }	// Older cycles
+				TObject *obj = k->ReadObj();
+				f.cd();
+				obj->Write( k->GetName() );
+				delete obj;
+			}
+		}
+		f.cd();
+		TH2F hEx( gridName + "_ex", "Ex [MeV] (" + key + ");E [MeV];z [cm]", fNE, kKinEMin - kKinEStep/2,
+			kKinEMax + kKinEStep/2, fNZ, kKinZMin - kKinZStep/2, kKinZMax + kKinZStep/2 );
+		TH2F hTheta( gridName + "_theta", "#theta_{CM} [deg] (" + key + ");E [MeV];z [cm]", fNE,
+			kKinEMin - kKinEStep/2, kKinEMax + kKinEStep/2, fNZ, kKinZMin - kKinZStep/2, kKinZMax + kKinZStep/2 );
+		TH2C hCell( gridName + "_cell", "Interpolated cells (" + key + ");E [MeV];z [cm]", fNE - 1, kKinEMin,
+			kKinEMax, fNZ - 1, kKinZMin, kKinZMax );
+		for ( Int_t i = 0; i < fNE; i++ ){
+			for ( Int_t j = 0; j < fNZ; j++ ){
+				hEx.SetBinContent( i + 1, j + 1, fEx[ i*fNZ + j ] );
+				hTheta.SetBinContent( i + 1, j + 1, fTheta[ i*fNZ + j ] );
+				if ( i < fNE - 1 && j < fNZ - 1 ){ hCell.SetBinContent( i + 1, j + 1, fCell[ i*( fNZ - 1 ) + j ] ); }
+			}
+		}
+		hEx.SetDirectory(0);
+		hTheta.SetDirectory(0);
+		hCell.SetDirectory(0);
+		hEx.Write( "", TObject::kOverwrite );
+		hTheta.Write( "", TObject::kOverwrite );
+		hCell.Write( "", TObject::kOverwrite );
+		TParameter<Double_t>( gridName + "_exerr", MaxExError ).Write( "", TObject::kOverwrite );
+		TParameter<Double_t>( gridName + "_thetaerr", MaxThetaError ).Write( "", TObject::kOverwrite );
+		f.Close();
+		if ( gSystem->Rename( tmpName.Data(), cacheName.Data() ) != 0 ){
+			printf("Cannot replace %s with %s\n", cacheName.Data(), tmpName.Data() );
+			gSystem->Unlink( tmpName.Data() );
+		}
+	}
+};
+
+// Reaction hypotheses of a run, each with its grid. The table file has one line per hypothesis:
+//   name  mass_b  charge_b  E_cm_total  mass_B  beta_cm  B_field
+// (MeV/c^2, e, MeV, MeV/c^2, c, T), as the exCorr arrays of PTMonitors; # starts a comment. The
+// order of the lines is the index of the hypothesis in the Ex_h/thetaCM_h branches.
+class ReactionTable {
+public:
+	Int_t          N;
+	TString        Name[kMaxHypotheses];
+	Reaction       Reac[kMaxHypotheses];
+	KinematicsGrid Grid[kMaxHypotheses];
+
+	ReactionTable() : N(0) {}
+
+	void Clear(){ N = 0; }
+
+	// Add a hypothesis from its exCorr constants, radius being that of the array [mm]
+	Bool_t Add( const TString &name, const Float_t *c, Double_t radius ){
+		if ( N == kMaxHypotheses ){
+			printf("Only %d reaction hypotheses can be used, %s left out\n", kMaxHypotheses, name.Data() );
+			return kFALSE;
+		}
+		Name[N] = name;
+		Reac[N].Set( c, radius );
+		N++;
+		return kTRUE;
+	}
+
+	Bool_t Load( const TString &fileName, Double_t radius ){
+		Clear();
+		std::ifstream in( fileName.Data() );
+		if ( !in.is_open() ){
+			printf("Cannot open reaction table %s\n", fileName.Data() );
+			return kFALSE;
+		}
+
+		std::string line;
+		Int_t lineNum = 0;
+		while ( std::getline( in, line ) ){
+			lineNum++;
+			if ( line.find('#') != std::string::npos ){ line = line.substr( 0, line.find('#') ); }
+			std::istringstream words( line );
+			std::string name;
+			Float_t c[6];
+			if ( !( words >> name ) ){ continue; }	// Blank or comment line
+			if ( !( words >> c[0] >> c[1] >> c[2] >> c[3] >> c[4] >> c[5] ) || c[4] <= 0 || c[4] >= 1 ){
+				printf("Bad line %d in reaction table %s: %s\n", lineNum, fileName.Data(), line.c_str() );
+				Clear();
+				return kFALSE;
+			}
+			if ( !Add( name.c_str(), c, radius ) ){ break; }
+		}
+		if ( N == 0 ){ printf("No reactions in %s\n", fileName.Data() ); }
+		return ( N > 0 );
+	}
+
+	// Take the grid of every hypothesis from the cache, or build it (see KinematicsGrid::Build)
+	void Build( const TString &cacheName, Bool_t use = kTRUE ){
+		for ( Int_t h = 0; h < N; h++ ){
+			Grid[h].Build( Reac[h], Name[h].Data(), cacheName, use );
+		}
+	}
+
+	// Ex and thetaCM of the 24 detectors for every hypothesis, ex[h][i] and thetaCM[h][i], with the
+	// hits off the grids of all of them solved in one batch
+	void Eval( const Float_t *e, const Float_t *z, Float_t ex[][24], Float_t thetaCM[][24], KinematicsBatch &batch ){
+		for ( Int_t h = 0; h < N; h++ ){
+			Grid[h].EvalBatch( 24, e, z, ex[h], thetaCM[h], batch );
+		}
+		batch.Solve();
+	}
+
+	// Names of the hypotheses in index order, e.g. "mg si"
+	TString Names() const {
+		TString names;
+		for ( Int_t h = 0; h < N; h++ ){ names += ( h ? " " : "" ) + Name[h]; }
+		return names;
+	}
+
+	// Write the names into the current directory, as "reactions"
+	void Write() const {
+		TNamed named( "reactions", Names().Data() );
+		named.Write( "", TObject::kOverwrite );
+	}
+
+	void PrintUsage() const {
+		for ( Int_t h = 0; h < N; h++ ){ Grid[h].PrintUsage( Name[h].Data() ); }
+	}
+};
+
+#endif
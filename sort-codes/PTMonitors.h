@@ -4,6 +4,7 @@
 
 // Include some stuff
 #include "WriteSPE.h"
+#include "GS_HitList.h"
 #include <TROOT.h>
 #include <TChain.h>
 #include <TFile.h>
@@ -172,7 +173,7 @@ TString ConstructFinFileName( TTree *t ){
 	TString out_name = "";
 	Bool_t alpha_run = 0;
 	
-	if ( t->GetCurrentFile() != NULL ){
+	if ( t != NULL && t->GetCurrentFile() != NULL ){
 		// Get the file name from the TTree
 		file_name = t->GetCurrentFile()->GetName();
 		
@@ -251,6 +252,8 @@ public :
 	Float_t         ezero[10];		// ???
 	ULong64_t       ezero_t[10];	// ^^ timestamp
 	ULong64_t		ebis_t;		// EBIS timestamp
+	Float_t         e_ft[100];		// CFD fine time of e, in ticks (GS_CFDTiming.h)
+	Float_t         rdt_ft[100];	// ^^ of rdt
 
 	// List of branches to hold said leaves
 	TBranch        *b_Energy;   //!
@@ -268,9 +271,45 @@ public :
 	TBranch        *b_EZERO;   //!
 	TBranch        *b_EZEROTimestamp;   //!
 	TBranch		   *b_EBISTimestamp;
+	TBranch        *b_EnergyFine;   //!
+	TBranch        *b_RDTFine;   //!
+	Bool_t          haveFine;		// gen_tree has the fine-time branches
+
+	// Hit-list gen_tree layout (GeneralSort "format=hits"), unpacked into the arrays above. Events
+	// handed over with SetEvent() come the same way.
+	Bool_t          hitFormat;
+	HitList         hits;
+	Float_t        *hitEnergy[kNumHitKinds];		// Array each kind of hit is unpacked into
+	ULong64_t      *hitTimestamp[kNumHitKinds];	// ^^ timestamp
+	Float_t        *hitFine[kNumHitKinds];		// ^^ fine time, NULL for kinds without one
+	TBranch        *b_NHits;   //!
+	TBranch        *b_HitKind;   //!
+	TBranch        *b_HitDet;   //!
+	TBranch        *b_HitEnergy;   //!
+	TBranch        *b_HitTimestamp;   //!
+	TBranch        *b_HitFine;   //!
 
 	// CLASS MEMBER FUNCTIONS
-	PTMonitors(TTree * /*tree*/ =0) : fChain(0) { }		// Constructor
+	PTMonitors(TTree * /*tree*/ =0) : fChain(0), haveFine(kFALSE), hitFormat(kFALSE) {		// Constructor
+		Float_t *energy[kNumHitKinds] = { e, xf, xn, rdt, tac, elum, ezero };
+		ULong64_t *timestamp[kNumHitKinds] = { e_t, xf_t, xn_t, rdt_t, tac_t, elum_t, ezero_t };
+		for ( Int_t k = 0; k < kNumHitKinds; k++ ){
+			hitEnergy[k] = energy[k];
+			hitTimestamp[k] = timestamp[k];
+			hitFine[k] = NULL;
+
+			// Start with every slot empty, as in the array layout
+			for ( Int_t i = 0; i < kHitKindSize[k]; i++ ){
+				hitEnergy[k][i] = TMath::QuietNaN();
+				hitTimestamp[k][i] = TMath::QuietNaN();
+			}
+		}
+		hitFine[kHitE] = e_ft;
+		hitFine[kHitRDT] = rdt_ft;
+		ClearFine();
+		hits.NHits = 0;
+		ebis_t = 0;
+	}
 	virtual ~PTMonitors() { }							// Destructor
 	virtual Int_t   Version() const { return 3; }		// Version of this class
 	
@@ -290,6 +329,19 @@ public :
 	virtual void    SetInputList(TList *input) { fInput = input; }
 	virtual TList  *GetOutputList() const { return fOutput; }
 
+	// Hand-off from a sorter in the same process (GeneralSortOnline.C), used instead of a
+	// gen_tree: Begin(0), then SetEvent() and ProcessEvent() for every event, then Terminate()
+	void            SetEvent( const HitList &list, ULong64_t ebis );
+	Bool_t          ProcessEvent();
+	void            Refresh();		// Save fin_tree and the monitor histograms so far
+
+	void            ClearFine(){
+		for ( Int_t i = 0; i < 100; i++ ){
+			e_ft[i] = TMath::QuietNaN();
+			rdt_ft[i] = TMath::QuietNaN();
+		}
+	}
+
 	ClassDef(PTMonitors,0);
 };
 
@@ -311,6 +363,23 @@ void PTMonitors::Init(TTree *tree)
 	fChain = tree;
 	fChain->SetMakeClass(1);
 
+	// CFD fine times (GeneralSort on a raw tree with CFD words), NaN when the file has none
+	ClearFine();
+	haveFine = ( tree->GetBranch("e_ft") != NULL || tree->GetBranch("hit_ft") != NULL );
+
+	// Sparse hit-list layout - read the list and unpack it in Process()
+	hitFormat = IsHitListTree( tree );
+	if ( hitFormat ){
+		fChain->SetBranchAddress("nhit", &hits.NHits, &b_NHits);
+		fChain->SetBranchAddress("hit_kind", hits.Kind, &b_HitKind);
+		fChain->SetBranchAddress("hit_det", hits.Det, &b_HitDet);
+		fChain->SetBranchAddress("hit_e", hits.Energy, &b_HitEnergy);
+		fChain->SetBranchAddress("hit_t", hits.Timestamp, &b_HitTimestamp);
+		if ( haveFine ){ fChain->SetBranchAddress("hit_ft", hits.Fine, &b_HitFine); }
+		fChain->SetBranchAddress("EBIS", &ebis_t, &b_EBISTimestamp);
+		return;
+	}
+
 	fChain->SetBranchAddress("e", e, &b_Energy);
 	fChain->SetBranchAddress("e_t", e_t, &b_EnergyTimestamp);
 	fChain->SetBranchAddress("xf", xf, &b_XF);
@@ -326,6 +395,10 @@ void PTMonitors::Init(TTree *tree)
 	fChain->SetBranchAddress("ezero", ezero, &b_EZERO);
 	fChain->SetBranchAddress("ezero_t", ezero_t, &b_EZEROTimestamp);
 	fChain->SetBranchAddress("EBIS", &ebis_t, &b_EBISTimestamp);
+	if ( haveFine ){
+		fChain->SetBranchAddress("e_ft", e_ft, &b_EnergyFine);
+		fChain->SetBranchAddress("rdt_ft", rdt_ft, &b_RDTFine);
+	}
 }
 
 Bool_t PTMonitors::Notify()
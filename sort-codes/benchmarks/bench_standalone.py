@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# Start-up and throughput of the standalone executables (iss-sort, iss-monitor, iss-analyse, built
+# with the CMakeLists.txt at the top of the repository) against the ACLiC path, t->Process("X.C+").
+# A reference raw run is taken through the three stages both ways. For each stage and path:
+#   startup_s   wall time of a run with max=1, i.e. process start, loading and Begin/Terminate.
+#               For ACLiC it is timed twice: "aclic-compile" forces the compile (X.C++) and
+#               "aclic" loads the library compiled before
+#   full_s      wall time of the whole stage
+#   entries     entries of the input tree
+#   kevents_per_s   entries/(full_s - startup_s), the per-event throughput
+# The table is written to --out (and printed).
+#   python3 bench_standalone.py --raw run25.root --bindir ../../build
+# =============================================================================================== #
+import argparse
+import os
+import re
+import subprocess
+import time
+
+here = os.path.dirname(os.path.abspath(__file__))
+top = os.path.join(here, "..", "..")
+
+parser = argparse.ArgumentParser(description="Compare the standalone executables with the ACLiC macros")
+parser.add_argument("--raw", required=True, help="reference raw run (tree)")
+parser.add_argument("--bindir", default=os.path.join(top, "build"), help="directory of iss-sort etc.")
+parser.add_argument("--sortdir", default=os.path.join(here, ".."), help="directory of GeneralSort.C and PTMonitors.C")
+parser.add_argument("--analysedir", default=os.path.join(top, "analysis-codes", "analyse-tree"),
+	help="directory of AnalyseTree.C")
+parser.add_argument("--map", default=os.path.join(top, "working", "map.dat"))
+parser.add_argument("--option", default="", help="extra options for every stage")
+parser.add_argument("--repeat", type=int, default=3, help="runs of each measurement, the fastest is kept")
+parser.add_argument("--work", default=os.path.join(here, "bench_work"), help="directory for temporary files")
+parser.add_argument("--out", default=os.path.join(here, "bench_standalone.tsv"))
+args = parser.parse_args()
+
+columns = ["stage", "path", "startup_s", "full_s", "entries", "kevents_per_s"]
+
+# Stage: (selector macro, executable, input tree, input file, output file)
+stages = [
+	("sort", os.path.join(args.sortdir, "GeneralSort.C"), "iss-sort", "tree",
+		os.path.abspath(args.raw), "gen.root"),
+	("monitor", os.path.join(args.sortdir, "PTMonitors.C"), "iss-monitor", "gen_tree", "gen.root", "fin.root"),
+	("analyse", os.path.join(args.analysedir, "AnalyseTree.C"), "iss-analyse", "fin_tree", "fin.root", None),
+]
+
+
+def timed(cmd, log):
+	# Wall time of a command, or None if it failed
+	t0 = time.time()
+	with open(log, "w") as f:
+		status = subprocess.call(cmd, stdout=f, stderr=subprocess.STDOUT)
+	wall = time.time() - t0
+	if status != 0:
+		print("  %s failed (exit %d), see %s" % (cmd[0], status, log))
+		return None
+	return wall
+
+
+def best(cmd, log, repeat):
+	times = [timed(cmd, log) for i in range(repeat)]
+	times = [t for t in times if t is not None]
+	return min(times) if times else float("nan")
+
+
+def entries(fileName, treeName):
+	out = subprocess.run(["root", "-l", "-b", "-q", "-e",
+		'TFile f("%s"); printf("ENTRIES %%lld\\n", ((TTree*)f.Get("%s"))->GetEntries());' % (fileName, treeName)],
+		stdout=subprocess.PIPE, universal_newlines=True).stdout
+	m = re.search(r"^ENTRIES\s+(\d+)", out, re.M)
+	return int(m.group(1)) if m else 0
+
+
+def aclic(macro, tree, inFile, option, force):
+	process = '((TTree*)f.Get("%s"))->Process("%s%s","%s")' % (tree, macro, "++" if force else "+", option)
+	return ["root", "-l", "-b", "-q", "-e", 'TFile f("%s"); %s;' % (inFile, process)]
+
+
+def standalone(exe, inFile, option):
+	return [os.path.join(args.bindir, exe), inFile] + option.split()
+
+
+os.makedirs(args.work, exist_ok=True)
+os.chdir(args.work)
+rows = []
+for name, macro, exe, tree, inFile, outFile in stages:
+	option = "map=%s %s" % (os.path.abspath(args.map), args.option) if name == "sort" else args.option
+	# The max=1 runs write elsewhere, so that the full output is left as the input of the next stage
+	full = option + (" out=%s" % outFile if outFile else "")
+	start = option + (" out=startup-%s" % outFile if outFile else "") + " max=1"
+	log = os.path.join(args.work, "%s.log" % name)
+	print(name)
+
+	n = entries(inFile, tree)
+	fullAclic = best(aclic(macro, tree, inFile, full, False), log, args.repeat)
+	compileAclic = timed(aclic(macro, tree, inFile, start, True), log)
+	startAclic = best(aclic(macro, tree, inFile, start, False), log, args.repeat)
+	fullExe = best(standalone(exe, inFile, full), log, args.repeat)
+	startExe = best(standalone(exe, inFile, start), log, args.repeat)
+
+	rows.append([name, "aclic-compile", compileAclic if compileAclic else float("nan"), float("nan"), n, float("nan")])
+	for path, tStart, tFull in (("aclic", startAclic, fullAclic), ("standalone", startExe, fullExe)):
+		rate = n/(tFull - tStart)/1000.0 if tFull > tStart else float("nan")
+		rows.append([name, path, tStart, tFull, n, rate])
+
+with open(args.out, "w") as f:
+	f.write("\t".join(columns) + "\n")
+	for r in rows:
+		f.write("\t".join(("%.4g" % x) if isinstance(x, float) else str(x) for x in r) + "\n")
+
+print("\n" + "".join("%-15s" % c for c in columns))
+for r in rows:
+	print("".join(("%-15.4g" % x) if isinstance(x, float) else ("%-15s" % x) for x in r))
@@ -0,0 +1,8 @@
+// Dictionary of AnalyseTree for iss-analyse (see CMakeLists.txt)
+#ifdef __CLING__
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+
+#pragma link C++ class AnalyseTree+;
+#endif
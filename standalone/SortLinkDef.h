@@ -0,0 +1,9 @@
+// Dictionary of the sort selectors for iss-sort (see CMakeLists.txt)
+#ifdef __CLING__
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+
+#pragma link C++ class GeneralSort+;
+#pragma link C++ class inflightSort+;
+#endif
@@ -0,0 +1,53 @@
+// iss_analyse.cxx
+// iss-analyse: AnalyseTree as a compiled executable, in place of t->Process("AnalyseTree.C+"). The
+// first argument is the fin file and the rest are AnalyseTree options (the quick-look options, ...).
+// With tmin=/tmax= only the entries of that time window are read, through the ts_index of the file
+// as in ProcessTimeWindow.C, e.g.
+//   iss-analyse fin25.root tmin=2400 tmax=2700
+// ============================================================================================= //
+#include "AnalyseTree.h"
+#include "GS_Options.h"
+#include "GS_TimeIndex.h"
+#include <TFile.h>
+#include <TStopwatch.h>
+#include <TString.h>
+#include <TTree.h>
+#include <cstdio>
+
+int main( int argc, char **argv ){
+	if ( argc < 2 || TString( argv[1] ).BeginsWith("-") ){
+		printf("Usage: iss-analyse <fin.root> [tree=fin_tree] [tmin=s] [tmax=s] [AnalyseTree options]\n");
+		return 1;
+	}
+	TString option;
+	for ( Int_t i = 2; i < argc; i++ ){
+		option += ( option.Length() ? " " : "" ) + TString( argv[i] );
+	}
+
+	TStopwatch watch;
+	TFile f( argv[1] );
+	TString treeName = GetOptionValue( option, "tree", "fin_tree" );
+	TTree *t = (TTree*)f.Get( treeName );
+	if ( t == NULL ){
+		printf("No %s in %s\n", treeName.Data(), argv[1] );
+		return 1;
+	}
+
+	// Entry range of the time window, if there is one
+	Long64_t first = 0, n = t->GetEntries();
+	if ( HasOption( option, "tmin" ) || HasOption( option, "tmax" ) ){
+		Double_t tmin = GetOptionValue( option, "tmin", "0" ).Atof();
+		Double_t tmax = GetOptionValue( option, "tmax", "0" ).Atof();
+		if ( TimeWindowEntries( t, tmin, tmax, first, n ) ){
+			printf("%g-%g s: entries %lld to %lld of %lld\n", tmin, tmax, first, first + n, t->GetEntries() );
+			option += Form( " tref=%llu", TimeIndexStart( t ) );
+		}
+		if ( n == 0 ){ return 0; }
+	}
+
+	AnalyseTree sel;
+	t->Process( &sel, option, n, first );
+	f.Close();
+	printf("iss-analyse: %.1f s\n", watch.RealTime() );
+	return 0;
+}
@@ -0,0 +1,42 @@
+// iss_monitor.cxx
+// iss-monitor: PTMonitors as a compiled executable, in place of t->Process("PTMonitors.C+"). The
+// first argument is the gen file and the rest are PTMonitors options (out=, rdtwin=, coinconly,
+// the quick-look and output-tuning options, ...), e.g.
+//   iss-monitor gen25.root out=fin25.root rdtwin=20
+// PTMonitors.h defines globals, so PTMonitors.C is compiled only in its dictionary and the
+// selector is made through it here rather than by including the header a second time.
+// ============================================================================================= //
+#include "GS_Options.h"
+#include <TClass.h>
+#include <TFile.h>
+#include <TSelector.h>
+#include <TStopwatch.h>
+#include <TString.h>
+#include <TTree.h>
+#include <cstdio>
+
+int main( int argc, char **argv ){
+	if ( argc < 2 || TString( argv[1] ).BeginsWith("-") ){
+		printf("Usage: iss-monitor <gen.root> [tree=gen_tree] [PTMonitors options]\n");
+		return 1;
+	}
+	TString option;
+	for ( Int_t i = 2; i < argc; i++ ){
+		option += ( option.Length() ? " " : "" ) + TString( argv[i] );
+	}
+
+	TStopwatch watch;
+	TFile f( argv[1] );
+	TString treeName = GetOptionValue( option, "tree", "gen_tree" );
+	TTree *t = (TTree*)f.Get( treeName );
+	if ( t == NULL ){
+		printf("No %s in %s\n", treeName.Data(), argv[1] );
+		return 1;
+	}
+	TSelector *sel = (TSelector*)TClass::GetClass("PTMonitors")->New();
+	t->Process( sel, option );
+	delete sel;
+	f.Close();
+	printf("iss-monitor: %.1f s\n", watch.RealTime() );
+	return 0;
+}
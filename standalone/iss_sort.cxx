@@ -0,0 +1,92 @@
+// iss_sort.cxx
+// iss-sort: GeneralSort as a compiled executable, in place of t->Process("GeneralSort.C+") and the
+// GeneralSortMT.C/GeneralSortGEB.C macros. Arguments ending in .root, or naming .gtd files, are the
+// input; all others are GeneralSort options, as given to TTree::Process (map=, out=, format=hits,
+// the quick-look options, ...). Several .root files are sorted as one TChain of their raw trees
+// (on one thread only), into one gen file. Also:
+//   threads=N    sort on N threads (GeneralSortMT)
+//   window=T     event-building window in ticks for .gtd input (1000 by default, GeneralSortGEB)
+//   --inflight   sort with inflightSort (TAC/EZERO into infl_tree), raw tree input only
+// e.g.
+//   iss-sort run25.root out=gen25.root map=../working/map.dat threads=16
+//   iss-sort iss000_run_25.gtd* out=gen25.root
+// ============================================================================================= //
+#include "GeneralSort.h"
+#include "inflightSort.h"
+#include "GS_Options.h"
+#include <TChain.h>
+#include <TFile.h>
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TStopwatch.h>
+#include <TString.h>
+#include <TTree.h>
+#include <cstdio>
+
+// GeneralSortMT.C and GeneralSortGEB.C
+void GeneralSortMT( TString inName, Int_t nThreads, TString outName, TString option );
+void GeneralSortGEB( TString inName, TString outName, ULong64_t timeWindow, TString option );
+
+int main( int argc, char **argv ){
+	TString input, option;
+	Bool_t inflight = kFALSE, gtd = kFALSE;
+	Int_t numRoot = 0;
+	for ( Int_t i = 1; i < argc; i++ ){
+		TString arg = argv[i];
+		if ( arg == "--inflight" ){ inflight = kTRUE; }
+		else if ( arg == "-h" || arg == "--help" ){ input = ""; break; }
+		else if ( !arg.Contains("=") && ( arg.EndsWith(".root") || arg.Contains(".gtd") ) ){
+			gtd |= arg.Contains(".gtd");
+			numRoot += arg.EndsWith(".root");
+			input += ( input.Length() ? " " : "" ) + arg;
+		}
+		else{ option += ( option.Length() ? " " : "" ) + arg; }
+	}
+	if ( input.Length() == 0 ){
+		printf("Usage: iss-sort [--inflight] <run.root | file.gtd ...> [threads=N] [window=T] [GeneralSort options]\n");
+		return 1;
+	}
+
+	TStopwatch watch;
+	Int_t threads = GetOptionValue( option, "threads", "1" ).Atoi();
+	if ( inflight && ( gtd || threads > 1 ) ){
+		printf("--inflight sorts a raw tree on one thread only\n");
+		return 1;
+	}
+	if ( gtd && numRoot > 0 ){
+		printf("Give either .gtd files or raw .root files, not both\n");
+		return 1;
+	}
+	if ( numRoot > 1 && threads > 1 ){
+		printf("threads= sorts one raw file: give one .root file, or sort several on one thread\n");
+		return 1;
+	}
+
+	if ( gtd ){
+		GeneralSortGEB( input, GetOptionValue( option, "out", "gen.root" ),
+			GetOptionValue( option, "window", "1000" ).Atoll(), option );
+	}
+	else if ( threads > 1 ){
+		GeneralSortMT( input, threads, GetOptionValue( option, "out", "gen.root" ), option );
+	}
+	else{
+		TChain chain("tree");
+		TObjArray *files = input.Tokenize(" ");
+		for ( Int_t i = 0; i < files->GetEntries(); i++ ){
+			TString name = ((TObjString*)files->At(i))->GetString();
+			if ( chain.AddFile( name, 0 ) == 0 ){		// 0: open it now, to check the tree is there
+				printf("No raw tree in %s\n", name.Data() );
+				delete files;
+				return 1;
+			}
+		}
+		delete files;
+		GeneralSort *sel = ( inflight ? new inflightSort() : new GeneralSort() );
+		chain.Process( sel, option );
+		Bool_t failed = sel->Failed;
+		delete sel;
+		if ( failed ){ return 1; }
+	}
+	printf("iss-sort: %.1f s\n", watch.RealTime() );
+	return 0;
+}
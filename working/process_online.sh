@@ -0,0 +1,27 @@
+#!/bin/sh
+
+# Sorts a run while it is being taken: tails the digitizer .gtd files of the
+# run as they are written (GeneralSortOnline.C) and keeps gen.root and
+# fin_online.root up to date, with EVZ, EXE and TD_Recoil shown on screen.
+# Stops once no data has arrived for 10 minutes.
+
+if [ $# -eq 0 ]
+then
+    read -p 'Please enter the run number you would like to follow: ' RUN
+fi
+
+RUN=$1
+
+exp=iss631
+expDir=/home/helios/experiments/${exp}/analysis
+sortDir=${expDir}/sort_codes
+
+# One stream per digitizer file (the unchunked file or its _000); later chunks
+# (_001 ... _999) are picked up as they appear
+FILES=`ls ${expDir}/data/${exp}_run_${RUN}.gtd* | awk '!/_[0-9][0-9][0-9]$/ || /_000$/' | tr '\n' ' '`
+
+root -l -e ".L ${sortDir}/GeneralSort.C+" -e ".L ${sortDir}/PTMonitors.C+" \
+    "${sortDir}/GeneralSortOnline.C+(\"${FILES}\",\"draw run=${RUN}\")"
+
+cp gen.root ${expDir}/root_data/gen_run${RUN}.root
+echo copied gen.root to gen_run${RUN}.root
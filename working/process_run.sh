@@ -6,6 +6,7 @@ then
 fi
 
 RUN=$1
+NTHREADS=${2:-1} # >1 runs GeneralSort multithreaded
 
 exp=iss631
 expDir=/home/helios/experiments/${exp}/analysis
@@ -28,7 +29,7 @@ ${expDir}/working/gebsortmerged_local.sh $RUN
 echo Just created root file run${RUN}.root in ${expDir}/root_data/
 ls -ltrh ${expDir}/root_data
 
-root -q -b "process_run.C(${RUN},0)"
+root -q -b "process_run.C(${RUN},0,${NTHREADS})"
 cp gen.root ${expDir}/root_data/gen_run${RUN}.root
 echo copied gen.root to gen_run${RUN}.root
 
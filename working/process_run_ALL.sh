@@ -1,5 +1,6 @@
 #!/bin/bash
 # Sorts all of the data files (takes a long time!)
+# One run at a time - schedule_runs.py sorts the runs side by side on all cores
 # =============================================================================================== #
 # Patrick MacGregor
 # Nuclear Physics Research Group
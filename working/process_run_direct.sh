@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# As process_run.sh, but gen.root is sorted straight from the digitizer .gtd
+# files (GeneralSortGEB.C), which are decoded in parallel (one thread per
+# digitizer, in place of a gebsort.sh per digitizer) and merged in time order in
+# the sort itself, so GEBMerge, GEBSort_nogeb and the raw run tree are all skipped.
+# Pass "raw" as the second argument to still merge and write
+# root_data/run${RUN}.root, in which case gen.root is sorted from the merged file.
+
+if [ $# -eq 0 ]
+then
+    read -p 'Please enter the run number you would like to process: ' RUN
+fi
+
+RUN=$1
+RAW=${2:-noraw}
+
+exp=iss631
+expDir=/home/helios/experiments/${exp}/analysis
+
+if [ "${RAW}" = "raw" ]
+then
+    ${expDir}/working/gebmerge_local.sh $RUN
+    ${expDir}/working/gebsortmerged_local.sh $RUN
+    echo Just created root file run${RUN}.root in ${expDir}/root_data/
+    root -q -b "process_run.C(${RUN},2)"
+else
+    root -q -b "process_run.C(${RUN},3)"
+fi
+cp gen.root ${expDir}/root_data/gen_run${RUN}.root
+echo copied gen.root to gen_run${RUN}.root
+
+echo ----Done with Processing Run Number ${RUN}----
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+# Sorts a list of runs through the chain
+#   merge (GEBMerge) -> gebsort (GEBSort_nogeb) -> gensort (GeneralSort) -> monitor (PTMonitors)
+# with independent runs sorted side by side, in place of the one-run-at-a-time loops of
+# process_run_ALL.sh, sortall.sh and mergeall.sh. The stages of a run follow each other, and stages
+# of different runs are started whenever the core and memory budget allows (--jobs, --mem, with
+# --stage-mem the memory each stage is counted as using). Later stages are started before earlier
+# ones, so runs are finished (and their merged files removed with --clean) as early as possible.
+# Each stage writes its output to a log in --logdir/run<N>/, a failed stage skips the rest of its
+# run, and at the end a table of stage durations per run is printed and written to
+# --logdir/schedule_runs.tsv, along with the timeline in --logdir/schedule_runs.log.
+#   python3 schedule_runs.py --runs 10-125 --jobs 32
+#   python3 schedule_runs.py --runs 25,27,30-40 --stages gensort,monitor --option "reject=sync+error"
+# =============================================================================================== #
+import argparse
+import glob
+import os
+import subprocess
+import time
+
+here = os.path.dirname(os.path.abspath(__file__))
+STAGES = ["merge", "gebsort", "gensort", "monitor"]
+
+parser = argparse.ArgumentParser(description="Sort runs through the chain, several at a time")
+parser.add_argument("--runs", required=True, help="run list, e.g. 10-125 or 25,27,30-40")
+parser.add_argument("--stages", default=",".join(STAGES), help="stages to run, in chain order")
+parser.add_argument("--exp", default="iss000")
+parser.add_argument("--dir", default="/home/ptmac/Documents/07-CERN-ISS-Mg/analysis",
+	help="analysis directory holding GEBSort/, data/, merged_data/, root_data/ and working/")
+parser.add_argument("--sortdir", default=os.path.join(here, "..", "sort-codes"),
+	help="directory of GeneralSort.C and PTMonitors.C")
+parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="stages running at once")
+parser.add_argument("--mem", type=float, default=os.sysconf("SC_PAGE_SIZE")*os.sysconf("SC_PHYS_PAGES")/2.0**30*0.9,
+	help="memory budget in GB (90%% of the machine by default)")
+parser.add_argument("--stage-mem", default="merge=4,gebsort=2,gensort=1,monitor=1",
+	help="memory each stage is counted as using, in GB")
+parser.add_argument("--option", default="", help="extra GeneralSort/PTMonitors options")
+parser.add_argument("--calib", default=os.path.join(here, "calib.dat"), help="PTMonitors calibration file")
+parser.add_argument("--reactions", default=os.path.join(here, "reactions.dat"), help="PTMonitors reaction table")
+parser.add_argument("--kingrid", default=os.path.join(here, "kingrid.root"), help="PTMonitors kinematics grid cache")
+parser.add_argument("--logdir", default=os.path.join(here, "schedule_logs"))
+parser.add_argument("--skip-done", action="store_true", help="skip stages whose output is newer than their input")
+parser.add_argument("--clean", action="store_true", help="remove the merged .gtd files once a run is sorted")
+parser.add_argument("--dry-run", action="store_true", help="print the commands only")
+args = parser.parse_args()
+
+
+def run_list(text):
+	runs = []
+	for part in text.split(","):
+		if "-" in part:
+			first, last = part.split("-")
+			runs += range(int(first), int(last) + 1)
+		elif part != "":
+			runs.append(int(part))
+	return sorted(set(runs))
+
+
+def paths(run):
+	d = args.dir
+	return {
+		"data": sorted(glob.glob(os.path.join(d, "data", "%s_run_%d.gtd*" % (args.exp, run)))),
+		"merged": os.path.join(d, "merged_data", "GEBMerged_run%d.gtd" % run),
+		"raw": os.path.join(d, "root_data", "run%d.root" % run),
+		"gen": os.path.join(d, "root_data", "gen_run%d.root" % run),
+		"fin": os.path.join(d, "root_data", "fin%d.root" % run),
+	}
+
+
+def command(stage, run):
+	# Command line of one stage, with its input and output files
+	p = paths(run)
+	gebdir = os.path.join(args.dir, "GEBSort")
+	# The stages run in their log directories, so every file they read is given by absolute path
+	option = "map=%s run=%d quiet" % (os.path.join(here, "map.dat"), run)
+	if stage == "monitor":
+		option += " calib=%s reactions=%s kingrid=%s" % tuple(os.path.abspath(f) for f in (args.calib, args.reactions, args.kingrid))
+	option += " " + args.option
+	if stage == "merge":
+		return ([os.path.join(gebdir, "GEBMerge"), os.path.join(here, "GEBMerge.chat"), p["merged"]] + p["data"],
+			p["data"], p["merged"] + "_000")
+	if stage == "gebsort":
+		return ([os.path.join(gebdir, "GEBSort_nogeb"), "-input", "disk", p["merged"] + "_000", "-rootfile", p["raw"],
+			"RECREATE", "-chat", os.path.join(here, "GEBSort.chat")], [p["merged"] + "_000"], p["raw"])
+	inp, out = (p["raw"], p["gen"]) if stage == "gensort" else (p["gen"], p["fin"])
+	macro = 'schedule_stage.C("%s","%s","%s","%s","%s")' % (stage, inp, out, args.sortdir, option)
+	return ["root", "-l", "-b", "-q", os.path.join(here, macro)], [inp], out
+
+
+def is_done(inputs, output):
+	if not os.path.exists(output) or not inputs:
+		return False
+	return all(os.path.exists(f) and os.path.getmtime(f) <= os.path.getmtime(output) for f in inputs)
+
+
+def log(text):
+	line = "%s    %s" % (time.strftime("%Y-%m-%d %H:%M:%S"), text)
+	print(line)
+	with open(os.path.join(args.logdir, "schedule_runs.log"), "a") as f:
+		f.write(line + "\n")
+
+
+stages = [s for s in STAGES if s in args.stages.split(",")]
+stageMem = dict((k, float(v)) for k, v in (x.split("=") for x in args.stage_mem.split(",")))
+runs = run_list(args.runs)
+os.makedirs(args.logdir, exist_ok=True)
+open(os.path.join(args.logdir, "schedule_runs.log"), "w").close()
+
+# Compile the sort codes once, so that the stages do not all try to build them at the same time
+if not args.dry_run and ("gensort" in stages or "monitor" in stages):
+	compile = ["root", "-l", "-b", "-q"]
+	for c in ("GeneralSort.C", "PTMonitors.C"):
+		compile += ["-e", ".L %s+" % os.path.join(args.sortdir, c)]
+	if subprocess.call(compile) != 0:
+		raise SystemExit("Could not compile the sort codes in %s" % args.sortdir)
+
+# Per run: index of its next stage, and the duration/status of each stage
+nextStage = dict((r, 0) for r in runs)
+times = dict((r, {}) for r in runs)
+status = dict((r, "ok") for r in runs)
+running = {}		# pid -> (run, stage, start time, log file)
+usedMem = 0.0
+log("SORTING %d RUNS BEGINS (%s; %d jobs, %.0f GB)" % (len(runs), ",".join(stages), args.jobs, args.mem))
+t0 = time.time()
+
+while True:
+	# Ready stages: the next stage of every run that is not running or finished, latest stage first
+	busy = set(r for r, _, _, _ in running.values())
+	ready = [r for r in runs if r not in busy and status[r] == "ok" and nextStage[r] < len(stages)]
+	ready.sort(key=lambda r: (-nextStage[r], r))
+
+	for r in ready:
+		stage = stages[nextStage[r]]
+		mem = stageMem.get(stage, 1.0)
+		if len(running) >= args.jobs or (running and usedMem + mem > args.mem):
+			break
+		cmd, inputs, output = command(stage, r)
+		if not inputs:
+			status[r] = "failed:%s" % stage
+			log("Run %d %s has no input files" % (r, stage))
+			continue
+		if args.skip_done and is_done(inputs, output):
+			times[r][stage] = 0.0
+			nextStage[r] += 1
+			log("Run %d %s up to date" % (r, stage))
+			continue
+		if args.dry_run:
+			print(" ".join(cmd))
+			times[r][stage] = 0.0
+			nextStage[r] += 1
+			continue
+		logDir = os.path.join(args.logdir, "run%d" % r)
+		os.makedirs(logDir, exist_ok=True)
+		f = open(os.path.join(logDir, "%s.log" % stage), "w")
+		# Each stage in its own directory, for files written to the working directory (e.g. ACLiC's)
+		p = subprocess.Popen(cmd, stdout=f, stderr=subprocess.STDOUT, cwd=logDir)
+		running[p.pid] = (r, stage, time.time(), f)
+		usedMem += mem
+		log("Run %d %s start" % (r, stage))
+
+	if not running:
+		if not any(status[r] == "ok" and nextStage[r] < len(stages) for r in runs):
+			break
+		continue
+
+	# Wait for any stage to finish
+	pid, waitStatus, _ = os.wait4(-1, 0)
+	if pid not in running:
+		continue
+	r, stage, start, f = running.pop(pid)
+	f.close()
+	usedMem -= stageMem.get(stage, 1.0)
+	duration = time.time() - start
+	times[r][stage] = duration
+	if os.waitstatus_to_exitcode(waitStatus) != 0:
+		status[r] = "failed:%s" % stage
+		log("Run %d %s FAILED after %.0fs, see %s" % (r, stage, duration, f.name))
+		continue
+	nextStage[r] += 1
+	log("Run %d %s finish (%.0fs)" % (r, stage, duration))
+	if nextStage[r] == len(stages) and args.clean:
+		for m in glob.glob(paths(r)["merged"] + "_*"):
+			os.remove(m)
+
+wall = time.time() - t0
+log("SORTING RUNS FINISHES (%.0fs)" % wall)
+
+# Summary of the stage durations
+columns = ["run"] + stages + ["total", "status"]
+rows = [[r] + [times[r].get(s, 0.0) for s in stages] + [sum(times[r].values()), status[r]] for r in runs]
+with open(os.path.join(args.logdir, "schedule_runs.tsv"), "w") as f:
+	f.write("\t".join(columns) + "\n")
+	for row in rows:
+		f.write("\t".join(("%.1f" % x) if isinstance(x, float) else str(x) for x in row) + "\n")
+
+print("\n" + "".join("%-12s" % c for c in columns))
+for row in rows:
+	print("".join(("%-12.0f" % x) if isinstance(x, float) else ("%-12s" % x) for x in row))
+busyTime = sum(sum(t.values()) for t in times.values())
+print("%d runs, %d failed; wall time %.0fs for %.0fs of stages (%.1f at once on average)" % (len(runs),
+	sum(1 for r in runs if status[r] != "ok"), wall, busyTime, busyTime/wall if wall > 0 else 0))